@@ -1,28 +1,62 @@
 #include "devices/input.h"
 #include <debug.h>
-#include "devices/intq.h"
+#include "devices/ring.h"
 #include "devices/serial.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
 
-/* Stores keys from the keyboard and serial port. */
-static struct intq buffer;
+/* Stores keys from the keyboard and serial port.
+
+   The keyboard and serial interrupt handlers are the buffer's
+   producer; interrupts are off while they run, so they never
+   overlap.  Readers, its consumer, take `readers_lock' so that
+   only one at a time removes keys, and otherwise run with
+   interrupts on. */
+static struct ring buffer;
+static struct lock readers_lock;
+
+/* A reader that finds the buffer empty sets `reader_waiting'
+   and downs `keys_ready', which the producer ups on adding
+   keys. */
+static volatile bool reader_waiting;
+static struct semaphore keys_ready;
+
+/* Set by the producer when it fills the buffer, which makes the
+   serial driver stop accepting input, so that the next reader to
+   make room can let the serial driver know. */
+static volatile bool buffer_filled;
+
+static size_t read_keys (uint8_t *, size_t, bool line);
+static void keys_added (void);
 
 /* Initializes the input buffer. */
 void
 input_init (void) 
 {
-  intq_init (&buffer);
+  ring_init (&buffer);
+  lock_init (&readers_lock);
+  sema_init (&keys_ready, 0);
 }
 
 /* Adds a key to the input buffer.
    Interrupts must be off and the buffer must not be full. */
 void
 input_putc (uint8_t key) 
+{
+  input_put (&key, 1);
+}
+
+/* Adds the SIZE keys in KEYS to the input buffer.
+   Interrupts must be off and the buffer must have room for
+   them. */
+void
+input_put (const uint8_t *keys, size_t size)
 {
   ASSERT (intr_get_level () == INTR_OFF);
-  ASSERT (!intq_full (&buffer));
+  ASSERT (size <= ring_space (&buffer));
 
-  intq_putc (&buffer, key);
-  serial_notify ();
+  ring_put (&buffer, keys, size);
+  keys_added ();
 }
 
 /* Retrieves a key from the input buffer.
@@ -30,17 +64,87 @@ input_putc (uint8_t key)
 uint8_t
 input_getc (void) 
 {
-  enum intr_level old_level;
   uint8_t key;
 
-  old_level = intr_disable ();
-  key = intq_getc (&buffer);
-  serial_notify ();
-  intr_set_level (old_level);
-  
+  input_read (&key, 1);
   return key;
 }
 
+/* Retrieves up to SIZE keys from the input buffer into KEYS and
+   returns the number retrieved.  If the buffer is empty, waits
+   for a key to be pressed, so at least one key is retrieved if
+   SIZE is nonzero. */
+size_t
+input_read (uint8_t *keys, size_t size)
+{
+  return read_keys (keys, size, false);
+}
+
+/* Like input_read(), but stops after the first carriage return
+   or new-line, leaving any keys after it in the buffer for the
+   next read. */
+size_t
+input_read_line (uint8_t *keys, size_t size)
+{
+  return read_keys (keys, size, true);
+}
+
+/* Returns true if the input buffer is empty, so that the next
+   read would wait, false otherwise. */
+bool
+input_empty (void)
+{
+  return ring_empty (&buffer);
+}
+
+/* Retrieves up to SIZE keys from the input buffer into KEYS,
+   waiting for one if the buffer is empty, and returns the number
+   retrieved.  If LINE, stops after the first carriage return or
+   new-line. */
+static size_t
+read_keys (uint8_t *keys, size_t size, bool line)
+{
+  size_t cnt;
+
+  if (size == 0)
+    return 0;
+
+  lock_acquire (&readers_lock);
+  while (ring_empty (&buffer))
+    {
+      /* Check again after announcing ourselves, in case a key
+         arrived in between. */
+      reader_waiting = true;
+      barrier ();
+      if (ring_empty (&buffer))
+        sema_down (&keys_ready);
+      reader_waiting = false;
+    }
+  cnt = ring_peek (&buffer, keys, size);
+  if (line)
+    {
+      size_t i;
+      for (i = 0; i < cnt; i++)
+        if (keys[i] == '\r' || keys[i] == '\n')
+          {
+            cnt = i + 1;
+            break;
+          }
+    }
+  ring_skip (&buffer, cnt);
+  lock_release (&readers_lock);
+
+  if (buffer_filled)
+    {
+      enum intr_level old_level = intr_disable ();
+      buffer_filled = false;
+      serial_notify ();
+      intr_set_level (old_level);
+    }
+
+  return cnt;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
@@ -48,5 +152,33 @@ bool
 input_full (void) 
 {
   ASSERT (intr_get_level () == INTR_OFF);
-  return intq_full (&buffer);
+  return ring_full (&buffer);
+}
+
+/* Returns the number of keys that can be added to the input
+   buffer.
+   Interrupts must be off. */
+size_t
+input_space (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  return ring_space (&buffer);
+}
+
+/* Called by the producer after adding keys to the buffer.  Wakes
+   up a waiting reader and, if the buffer is now full, tells the
+   serial driver to stop receiving. */
+static void
+keys_added (void)
+{
+  if (reader_waiting)
+    {
+      reader_waiting = false;
+      sema_up (&keys_ready);
+    }
+  if (ring_full (&buffer))
+    {
+      buffer_filled = true;
+      serial_notify ();
+    }
 }
@@ -2,11 +2,17 @@
 #define DEVICES_INPUT_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 void input_init (void);
 void input_putc (uint8_t);
+void input_put (const uint8_t *, size_t);
 uint8_t input_getc (void);
+size_t input_read (uint8_t *, size_t);
+size_t input_read_line (uint8_t *, size_t);
+bool input_empty (void);
 bool input_full (void);
+size_t input_space (void);
 
 #endif /* devices/input.h */
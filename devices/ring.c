@@ -0,0 +1,107 @@
+#include "devices/ring.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/synch.h"
+
+/* Initializes ring buffer R as empty. */
+void
+ring_init (struct ring *r)
+{
+  r->head = r->tail = 0;
+}
+
+/* Returns the number of bytes in R. */
+size_t
+ring_count (const struct ring *r)
+{
+  return r->head - r->tail;
+}
+
+/* Returns the number of bytes that can be added to R. */
+size_t
+ring_space (const struct ring *r)
+{
+  return RING_BUFSIZE - ring_count (r);
+}
+
+/* Returns true if R is empty, false otherwise. */
+bool
+ring_empty (const struct ring *r)
+{
+  return r->head == r->tail;
+}
+
+/* Returns true if R is full, false otherwise. */
+bool
+ring_full (const struct ring *r)
+{
+  return ring_count (r) == RING_BUFSIZE;
+}
+
+/* Adds up to SIZE bytes from DATA to R, as many as fit, and
+   returns the number added.  Only R's producer may call this. */
+size_t
+ring_put (struct ring *r, const void *data_, size_t size)
+{
+  const uint8_t *data = data_;
+  unsigned head = r->head;
+  size_t space = RING_BUFSIZE - (head - r->tail);
+  size_t cnt = size < space ? size : space;
+  size_t ofs = head % RING_BUFSIZE;
+  size_t first = cnt < RING_BUFSIZE - ofs ? cnt : RING_BUFSIZE - ofs;
+
+  /* The consumer may have just freed the space we are about to
+     fill; make sure we don't write it before reading `tail'. */
+  barrier ();
+  memcpy (r->buf + ofs, data, first);
+  memcpy (r->buf, data + first, cnt - first);
+
+  /* Publish the bytes only once they are in the buffer. */
+  barrier ();
+  r->head = head + cnt;
+  return cnt;
+}
+
+/* Removes up to SIZE bytes from R into DATA, as many as R holds,
+   and returns the number removed.  Only R's consumer may call
+   this. */
+size_t
+ring_get (struct ring *r, void *data, size_t size)
+{
+  size_t cnt = ring_peek (r, data, size);
+  ring_skip (r, cnt);
+  return cnt;
+}
+
+/* Copies up to SIZE bytes from R into DATA, as many as R holds,
+   without removing them, and returns the number copied.  Only
+   R's consumer may call this. */
+size_t
+ring_peek (const struct ring *r, void *data_, size_t size)
+{
+  uint8_t *data = data_;
+  unsigned tail = r->tail;
+  size_t count = r->head - tail;
+  size_t cnt = size < count ? size : count;
+  size_t ofs = tail % RING_BUFSIZE;
+  size_t first = cnt < RING_BUFSIZE - ofs ? cnt : RING_BUFSIZE - ofs;
+
+  /* Don't read the bytes before reading the `head' that covers
+     them. */
+  barrier ();
+  memcpy (data, r->buf + ofs, first);
+  memcpy (data + first, r->buf, cnt - first);
+  return cnt;
+}
+
+/* Removes CNT bytes, which it must hold, from R without copying
+   them.  Only R's consumer may call this. */
+void
+ring_skip (struct ring *r, size_t cnt)
+{
+  ASSERT (cnt <= ring_count (r));
+
+  /* Free the space only once the bytes have been copied out. */
+  barrier ();
+  r->tail += cnt;
+}
@@ -0,0 +1,46 @@
+#ifndef DEVICES_RING_H
+#define DEVICES_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A single-producer, single-consumer ring buffer of bytes.
+
+   Unlike an intq, a ring needs no lock and no disabling of
+   interrupts, as long as there is only one producer and one
+   consumer at a time, e.g. an interrupt handler adding bytes and
+   a kernel thread removing them.  The producer only ever writes
+   `head' and the consumer only ever writes `tail', and each
+   publishes its update only after it has finished with the
+   buffer contents.  Pintos runs on a single CPU, so the other
+   party can only run in an interrupt or after a thread switch,
+   and compiler barriers are enough to keep those updates in
+   order.
+
+   Both sides move runs of bytes at a time.  Neither side blocks:
+   callers that want to wait for data or space must arrange that
+   themselves. */
+
+/* Ring buffer size, in bytes.  Must be a power of 2. */
+#define RING_BUFSIZE 256
+
+/* A ring buffer. */
+struct ring
+  {
+    volatile unsigned head;     /* Bytes ever added. */
+    volatile unsigned tail;     /* Bytes ever removed. */
+    uint8_t buf[RING_BUFSIZE];  /* Buffer. */
+  };
+
+void ring_init (struct ring *);
+size_t ring_count (const struct ring *);
+size_t ring_space (const struct ring *);
+bool ring_empty (const struct ring *);
+bool ring_full (const struct ring *);
+size_t ring_put (struct ring *, const void *, size_t);
+size_t ring_get (struct ring *, void *, size_t);
+size_t ring_peek (const struct ring *, void *, size_t);
+void ring_skip (struct ring *, size_t);
+
+#endif /* devices/ring.h */
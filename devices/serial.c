@@ -129,6 +129,45 @@ serial_putc (uint8_t byte)
   intr_set_level (old_level);
 }
 
+/* Sends the N bytes in BUFFER to the serial port, like calling
+   serial_putc() for each one, but updates the interrupt enable
+   register only once, when done or before waiting for room in
+   the transmit queue. */
+void
+serial_write (const uint8_t *buffer, size_t n)
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (mode != QUEUE)
+    {
+      if (mode == UNINIT)
+        init_poll ();
+      while (n-- > 0)
+        putc_poll (*buffer++);
+    }
+  else
+    {
+      while (n-- > 0)
+        {
+          if (intq_full (&txq))
+            {
+              /* As in serial_putc(), poll a byte out if we can't
+                 wait.  Otherwise make sure the transmit
+                 interrupt is on, so that the queue drains while
+                 intq_putc() waits. */
+              if (old_level == INTR_OFF)
+                putc_poll (intq_getc (&txq));
+              else
+                write_ier ();
+            }
+          intq_putc (&txq, *buffer++);
+        }
+      write_ier ();
+    }
+
+  intr_set_level (old_level);
+}
+
 /* Flushes anything in the serial buffer out the port in polling
    mode. */
 void
@@ -214,9 +253,21 @@ serial_interrupt (struct intr_frame *f UNUSED)
   inb (IIR_REG);
 
   /* As long as we have room to receive a byte, and the hardware
-     has a byte for us, receive a byte.  */
-  while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
-    input_putc (inb (RBR_REG));
+     has a byte for us, receive a byte.  Hand them to the input
+     buffer a FIFO's worth at a time. */
+  for (;;)
+    {
+      uint8_t keys[16];
+      size_t space = input_space ();
+      size_t cnt = 0;
+
+      while (cnt < space && cnt < sizeof keys
+             && (inb (LSR_REG) & LSR_DR) != 0)
+        keys[cnt++] = inb (RBR_REG);
+      if (cnt == 0)
+        break;
+      input_put (keys, cnt);
+    }
 
   /* As long as we have a byte to transmit, and the hardware is
      ready to accept a byte for transmission, transmit a byte. */
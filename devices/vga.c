@@ -26,6 +26,7 @@ static size_t cx, cy;
    The attribute at (x,y) is fb[y][x][1]. */
 static uint8_t (*fb)[COL_CNT][2];
 
+static void putc_locked (uint8_t c, enum intr_level);
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
@@ -50,13 +51,37 @@ init (void)
    characters in the conventional ways.  */
 void
 vga_putc (int c)
+{
+  char ch = c;
+  vga_write (&ch, 1);
+}
+
+/* Writes the N characters in BUFFER to the VGA text display,
+   like calling vga_putc() for each one, but updates the hardware
+   cursor only once at the end. */
+void
+vga_write (const char *buffer, size_t n)
 {
   /* Disable interrupts to lock out interrupt handlers
      that might write to the console. */
   enum intr_level old_level = intr_disable ();
 
   init ();
-  
+
+  while (n-- > 0)
+    putc_locked (*buffer++, old_level);
+
+  /* Update cursor position. */
+  move_cursor ();
+
+  intr_set_level (old_level);
+}
+
+/* Writes C to the VGA text display.  Interrupts must be off; the
+   caller had them at OLD_LEVEL before turning them off. */
+static void
+putc_locked (uint8_t c, enum intr_level old_level)
+{
   switch (c) 
     {
     case '\n':
@@ -95,13 +120,8 @@ vga_putc (int c)
         newline ();
       break;
     }
-
-  /* Update cursor position. */
-  move_cursor ();
-
-  intr_set_level (old_level);
 }
-
+
 /* Clears the screen and moves the cursor to the upper left. */
 static void
 cls (void)
@@ -0,0 +1,133 @@
+/* batchbench.c
+
+   Compares the cost of many small file operations made one
+   system call at a time with the same operations made through
+   a batch ring. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Scratch file used for the benchmark. */
+#define FILE_NAME "batchbench.tmp"
+
+/* Number of operations of each kind, and bytes in each. */
+#define OP_CNT 1024
+#define OP_SIZE 16
+
+static struct batch_ring ring;
+static char data[OP_CNT * OP_SIZE];
+static char check[OP_CNT * OP_SIZE];
+
+static uint64_t batch_ops (int fd, bool writing);
+static void report (const char *, uint64_t direct, uint64_t batched);
+
+/* Returns the processor's time-stamp counter. */
+static inline uint64_t
+read_tsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+int
+main (void)
+{
+  uint64_t start, direct_write, direct_read, batch_write, batch_read;
+  int fd, i;
+
+  for (i = 0; i < OP_CNT * OP_SIZE; i++)
+    data[i] = i % 251;
+
+  if (!create (FILE_NAME, 0) || (fd = open (FILE_NAME)) < 0)
+    {
+      printf ("%s: create failed\n", FILE_NAME);
+      return EXIT_FAILURE;
+    }
+  if (!batch_init (&ring))
+    {
+      printf ("batch_init failed\n");
+      return EXIT_FAILURE;
+    }
+
+  /* One system call per operation. */
+  start = read_tsc ();
+  for (i = 0; i < OP_CNT; i++)
+    write (fd, data + i * OP_SIZE, OP_SIZE);
+  direct_write = read_tsc () - start;
+
+  seek (fd, 0);
+  start = read_tsc ();
+  for (i = 0; i < OP_CNT; i++)
+    read (fd, check + i * OP_SIZE, OP_SIZE);
+  direct_read = read_tsc () - start;
+  if (memcmp (data, check, sizeof data))
+    {
+      printf ("direct: data mismatch\n");
+      return EXIT_FAILURE;
+    }
+
+  /* The same operations, a ring's worth per system call. */
+  seek (fd, 0);
+  batch_write = batch_ops (fd, true);
+  seek (fd, 0);
+  memset (check, 0, sizeof check);
+  batch_read = batch_ops (fd, false);
+  if (memcmp (data, check, sizeof data))
+    {
+      printf ("batched: data mismatch\n");
+      return EXIT_FAILURE;
+    }
+
+  close (fd);
+  remove (FILE_NAME);
+
+  printf ("cycles per %d-byte operation, %d operations:\n",
+          OP_SIZE, OP_CNT);
+  printf ("%-8s %10s %10s\n", "", "direct", "batched");
+  report ("write", direct_write, batch_write);
+  report ("read", direct_read, batch_read);
+  return EXIT_SUCCESS;
+}
+
+/* Writes DATA to FD, or if !WRITING reads it back into CHECK,
+   OP_SIZE bytes per call, through the batch ring.  Returns the
+   cycles taken. */
+static uint64_t
+batch_ops (int fd, bool writing)
+{
+  uint64_t start = read_tsc ();
+  int queued = 0;
+
+  while (queued < OP_CNT)
+    {
+      struct batch_cqe cqe;
+
+      for (; queued < OP_CNT; queued++)
+        {
+          bool ok = (writing
+                     ? batch_write (&ring, queued, fd,
+                                    data + queued * OP_SIZE, OP_SIZE)
+                     : batch_read (&ring, queued, fd,
+                                   check + queued * OP_SIZE, OP_SIZE));
+          if (!ok)
+            break;
+        }
+      batch_submit (&ring);
+      while (batch_reap (&ring, &cqe))
+        if (cqe.result != OP_SIZE)
+          printf ("operation %"PRIu32" returned %d\n", cqe.tag, cqe.result);
+    }
+  return read_tsc () - start;
+}
+
+/* Prints the cycles per operation for NAME made directly and
+   through the batch ring. */
+static void
+report (const char *name, uint64_t direct, uint64_t batched)
+{
+  printf ("%-8s %10"PRIu64" %10"PRIu64"\n",
+          name, direct / OP_CNT, batched / OP_CNT);
+}
@@ -5,6 +5,14 @@ Copies one file to another. */
 #include <stdio.h>
 #include <syscall.h>
 
+/* Size of one block, and number of blocks moved per readv or
+   writev. */
+#define BLOCK_SIZE 512
+#define BLOCK_CNT 4
+
+/* Bytes asked of each copy_file_range. */
+#define COPY_SIZE 65536
+
 int
 main (int argc, char *argv[]) 
 {
@@ -37,14 +45,49 @@ main (int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-  /* Copy data. */
+  /* Copy data inside the kernel if we can. */
+  for (;;)
+    {
+      int bytes_copied = copy_file_range (in_fd, out_fd, COPY_SIZE);
+      if (bytes_copied < 0)
+        break;
+      if (bytes_copied == 0) 
+        {
+          /* Nothing more could be copied: either the input is
+             used up, or the output could not be written. */
+          if (tell (in_fd) != (unsigned) filesize (in_fd)) 
+            {
+              printf ("%s: write failed\n", argv[2]);
+              return EXIT_FAILURE;
+            }
+          return EXIT_SUCCESS;
+        }
+    }
+
+  /* Otherwise, copy the rest BLOCK_CNT blocks per system call. */
   for (;;) 
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
+      static char blocks[BLOCK_CNT][BLOCK_SIZE];
+      struct iovec iov[BLOCK_CNT];
+      int bytes_read, left, i;
+
+      for (i = 0; i < BLOCK_CNT; i++)
+        {
+          iov[i].iov_base = blocks[i];
+          iov[i].iov_len = BLOCK_SIZE;
+        }
+      bytes_read = readv (in_fd, iov, BLOCK_CNT);
+      if (bytes_read <= 0)
         break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
+
+      /* Write back only the part of the blocks that was filled. */
+      left = bytes_read;
+      for (i = 0; left > 0; i++)
+        {
+          iov[i].iov_len = left < BLOCK_SIZE ? left : BLOCK_SIZE;
+          left -= iov[i].iov_len;
+        }
+      if (writev (out_fd, iov, i) != bytes_read) 
         {
           printf ("%s: write failed\n", argv[2]);
           return EXIT_FAILURE;
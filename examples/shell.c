@@ -54,33 +54,40 @@ read_line (char line[], size_t size)
   char *pos = line;
   for (;;)
     {
-      char c;
-      read (STDIN_FILENO, &c, 1);
+      /* A read returns all the keys that are waiting, but never
+         goes past the end of a line. */
+      char keys[64];
+      int key_cnt = read (STDIN_FILENO, keys, sizeof keys);
+      int i;
 
-      switch (c) 
+      for (i = 0; i < key_cnt; i++) 
         {
-        case '\r':
-          *pos = '\0';
-          putchar ('\n');
-          return;
+          char c = keys[i];
+          switch (c) 
+            {
+            case '\r':
+              *pos = '\0';
+              putchar ('\n');
+              return;
 
-        case '\b':
-          backspace (&pos, line);
-          break;
+            case '\b':
+              backspace (&pos, line);
+              break;
 
-        case ('U' - 'A') + 1:       /* Ctrl+U. */
-          while (backspace (&pos, line))
-            continue;
-          break;
+            case ('U' - 'A') + 1:       /* Ctrl+U. */
+              while (backspace (&pos, line))
+                continue;
+              break;
 
-        default:
-          /* Add character to line. */
-          if (pos < line + size - 1) 
-            {
-              putchar (c);
-              *pos++ = c;
+            default:
+              /* Add character to line. */
+              if (pos < line + size - 1) 
+                {
+                  putchar (c);
+                  *pos++ = c;
+                }
+              break;
             }
-          break;
         }
     }
 }
@@ -1,7 +1,10 @@
 #include "filesys/file.h"
 #include <debug.h>
+#include "devices/block.h"
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
 
 /* An open file. */
 struct file 
@@ -11,19 +14,40 @@ struct file
     bool deny_write;            /* Has file_deny_write() been called? */
   };
 
+/* Cache of `struct file's. */
+static struct kmem_cache file_cache;
+static kmem_ctor_func file_ctor;
+
+/* Initializes the file module. */
+void
+file_init (void) 
+{
+  kmem_cache_init (&file_cache, "file", sizeof (struct file), file_ctor);
+}
+
+/* Constructs FILE_ for file_cache.  file_close() allows writes
+   again before freeing a file, so DENY_WRITE is always false in
+   a free file. */
+static void
+file_ctor (void *file_)
+{
+  struct file *file = file_;
+
+  file->deny_write = false;
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
    and returns the new file.  Returns a null pointer if an
    allocation fails or if INODE is null. */
 struct file *
 file_open (struct inode *inode) 
 {
-  struct file *file = calloc (1, sizeof *file);
+  struct file *file = kmem_cache_alloc (&file_cache);
   if (inode != NULL && file != NULL)
     {
       //printf("opening\n");
       file->inode = inode;
       file->pos = 0;
-      file->deny_write = false;
       return file;
     }
   else
@@ -31,7 +55,7 @@ file_open (struct inode *inode)
       //printf("file inode: %p\n", inode);
       //printf("inode or file is null\n");
       inode_close (inode);
-      free (file);
+      kmem_cache_free (&file_cache, file);
       return NULL; 
     }
 }
@@ -52,7 +76,7 @@ file_close (struct file *file)
     {
       file_allow_write (file);
       inode_close (file->inode);
-      free (file); 
+      kmem_cache_free (&file_cache, file); 
     }
 }
 
@@ -121,9 +145,62 @@ off_t
 file_write_at (struct file *file, const void *buffer, off_t size,
                off_t file_ofs) 
 {
+  /* As in file_write(), directories can't be written. */
+  if (inode_is_dir (file->inode))
+    return -1;
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Copies up to SIZE bytes from SRC, starting at its current
+   position, to DST, starting at its current position, and
+   advances both positions by the number of bytes copied.
+   The data moves through one kernel page at a time, never
+   through user memory.
+   Returns the number of bytes copied, which may be less than
+   SIZE if the end of SRC is reached or DST cannot grow, or -1
+   if DST is a directory, SRC and DST are the same inode, or no
+   page is available.  Copying within one inode is refused
+   because the ranges could overlap, and the copy would then
+   read back bytes it had just written. */
+off_t
+file_copy (struct file *dst, struct file *src, off_t size)
+{
+  uint8_t *buffer;
+  off_t bytes_copied = 0;
+
+  if (inode_is_dir (dst->inode) || dst->inode == src->inode)
+    return -1;
+  buffer = palloc_get_page (0);
+  if (buffer == NULL)
+    return -1;
+
+  while (size > 0)
+    {
+      /* End each chunk on a sector boundary in SRC, so that after
+         the first chunk whole sectors are read straight into the
+         buffer. */
+      off_t chunk_size = PGSIZE - src->pos % BLOCK_SECTOR_SIZE;
+      off_t bytes_read, bytes_written;
+
+      if (chunk_size > size)
+        chunk_size = size;
+      bytes_read = inode_read_at (src->inode, buffer, chunk_size, src->pos);
+      if (bytes_read == 0)
+        break;
+      bytes_written = inode_write_at (dst->inode, buffer, bytes_read,
+                                      dst->pos);
+      src->pos += bytes_written;
+      dst->pos += bytes_written;
+      bytes_copied += bytes_written;
+      size -= bytes_written;
+      if (bytes_written < bytes_read)
+        break;
+    }
+
+  palloc_free_page (buffer);
+  return bytes_copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
@@ -6,6 +6,8 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -53,6 +55,7 @@ struct inode
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    unsigned write_cnt;                 /* Number of writes so far. */
     struct inode_disk data;             /* Inode content. */
   };
 
@@ -132,11 +135,30 @@ byte_to_sector (const struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache of `struct inode's.  An in-memory inode embeds a copy of
+   its 512-byte on-disk inode, which malloc() would round up to a
+   1 kB block. */
+static struct kmem_cache inode_cache;
+static kmem_ctor_func inode_ctor;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  kmem_cache_init (&inode_cache, "inode", sizeof (struct inode), inode_ctor);
+}
+
+/* Constructs INODE_ for inode_cache.  Every opener that denies
+   writes allows them again before closing, so an inode's deny
+   count is back to 0 by the time it is freed and need not be
+   reset in inode_open(). */
+static void
+inode_ctor (void *inode_)
+{
+  struct inode *inode = inode_;
+
+  inode->deny_write_cnt = 0;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -368,7 +390,7 @@ inode_open (block_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = kmem_cache_alloc (&inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -376,7 +398,7 @@ inode_open (block_sector_t sector)
   list_push_front (&open_inodes, &inode->elem);
   inode->sector = sector;
   inode->open_cnt = 1;
-  inode->deny_write_cnt = 0;
+  inode->write_cnt = 0;
   inode->removed = false;
   block_read (fs_device, inode->sector, &inode->data);
   return inode;
@@ -430,7 +452,8 @@ inode_close (struct inode *inode)
             free_map_release(byte_to_sector(inode, i), 1);
           } 
         }
-      free (inode); 
+      ASSERT (inode->deny_write_cnt == 0);
+      kmem_cache_free (&inode_cache, inode); 
     }
 }
 
@@ -469,7 +492,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       if (chunk_size <= 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
+      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE
+          && !is_user_vaddr (buffer + bytes_read))
         {
           /* Read full sector directly into caller's buffer. */
           block_read (fs_device, sector_idx, buffer + bytes_read);
@@ -477,7 +501,11 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       else 
         {
           /* Read sector into bounce buffer, then partially copy
-             into caller's buffer. */
+             into caller's buffer.  User buffers always take
+             this path: a user page may be evicted at any time,
+             and the fault that brings it back in reads from the
+             swap disk, which must not happen in the middle of
+             block_read() on a channel it may share. */
           if (bounce == NULL) 
             {
               bounce = malloc (BLOCK_SECTOR_SIZE);
@@ -694,6 +722,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
   if (inode->deny_write_cnt)
     return 0;
+  inode->write_cnt++;
 
   while (size > 0) 
     {
@@ -714,9 +743,12 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       if (chunk_size <= 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
+      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE
+          && !is_user_vaddr (buffer + bytes_written))
         {
-          /* Write full sector directly to disk. */
+          /* Write full sector directly to disk.  As in
+             inode_read_at(), user buffers go through the bounce
+             buffer instead. */
           block_write (fs_device, sector_idx, buffer + bytes_written);
         }
       else 
@@ -752,6 +784,17 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   return bytes_written;
 }
 
+/* Returns the number of times INODE has been written since it
+   was opened.  A cache of anything derived from INODE's contents
+   can compare this with the value when it was filled to tell
+   whether it is still valid, for as long as it keeps INODE
+   open. */
+unsigned
+inode_write_cnt (const struct inode *inode)
+{
+  return inode->write_cnt;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
@@ -0,0 +1,61 @@
+#ifndef __LIB_BATCH_H
+#define __LIB_BATCH_H
+
+#include <stdint.h>
+
+/* Batched system calls.
+
+   A process can queue up system calls in a batch ring in its
+   own memory, registered with the kernel by the batch_setup
+   system call, and then have the kernel carry out all of them
+   with a single batch_enter system call, instead of trapping
+   into the kernel once for each.
+
+   The ring has two queues.  The process adds calls to the
+   submission queue, SQ, by filling in sq[sq_tail % SIZE] and
+   then advancing sq_tail.  The kernel carries out each call in
+   order, advancing sq_head, and posts its result to the
+   completion queue, CQ, by filling in cq[cq_tail % SIZE] and
+   advancing cq_tail.  The process consumes results by advancing
+   cq_head.  Each side only ever writes its own two indexes.
+
+   Only calls that act on files can be batched: create, remove,
+   open, close, filesize, read, write, seek, tell, pread, and
+   pwrite.  A read from the keyboard, which could block forever,
+   is not allowed.  Any other call completes with result -1.  A
+   call with a bad pointer or file descriptor kills the process,
+   just as it would if made directly. */
+
+/* Number of entries in each queue.  Must be a power of 2. */
+#define BATCH_RING_SIZE 32
+
+/* Most arguments a batched call takes. */
+#define BATCH_MAX_ARGS 4
+
+/* A submitted system call. */
+struct batch_sqe
+  {
+    int nr;                             /* System call number. */
+    uint32_t args[BATCH_MAX_ARGS];      /* Arguments. */
+    uint32_t tag;                       /* Copied to the completion. */
+  };
+
+/* A completed system call. */
+struct batch_cqe
+  {
+    uint32_t tag;                       /* Tag from the submission. */
+    int result;                         /* System call's return value. */
+  };
+
+/* A batch ring. */
+struct batch_ring
+  {
+    unsigned sq_head;                   /* Calls done, set by kernel. */
+    unsigned sq_tail;                   /* Calls queued, set by process. */
+    unsigned cq_head;                   /* Results taken, set by process. */
+    unsigned cq_tail;                   /* Results posted, set by kernel. */
+    struct batch_sqe sq[BATCH_RING_SIZE]; /* Submission queue. */
+    struct batch_cqe cq[BATCH_RING_SIZE]; /* Completion queue. */
+  };
+
+#endif /* lib/batch.h */
@@ -28,6 +28,7 @@ struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    size_t next_fit;    /* Start of bitmap_scan_and_flip_next(). */
   };
 
 /* Returns the index of the element that contains the bit
@@ -68,6 +69,60 @@ last_mask (const struct bitmap *b)
   int last_bits = b->bit_cnt % ELEM_BITS;
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns an elem_type in which CNT bits starting at bit OFS are
+   set to 1 and the rest are set to 0.  OFS + CNT must not exceed
+   ELEM_BITS. */
+static inline elem_type
+range_mask (size_t ofs, size_t cnt)
+{
+  elem_type mask = cnt < ELEM_BITS ? ((elem_type) 1 << cnt) - 1 : (elem_type) -1;
+  return mask << ofs;
+}
+
+/* Returns the number of bits set to 1 in X. */
+static inline size_t
+count_ones (elem_type x)
+{
+  /* Adds up adjacent bit fields of doubling widths in parallel.
+     See "Counting bits set, in parallel" in Sean Eron Anderson's
+     "Bit Twiddling Hacks". */
+  const elem_type ones = -1;
+  x = x - ((x >> 1) & ones / 3);
+  x = (x & ones / 15 * 3) + ((x >> 2) & ones / 15 * 3);
+  x = (x + (x >> 4)) & ones / 255 * 15;
+  return (elem_type) (x * (ones / 255)) >> (ELEM_BITS - CHAR_BIT);
+}
+
+/* Returns the index of the first bit in B at or after START, and
+   before END, that is set to VALUE, or END if there is none.
+   Works an element at a time, so runs of elements that have no
+   bits set to VALUE are skipped quickly. */
+static size_t
+find_bit (const struct bitmap *b, size_t start, size_t end, bool value)
+{
+  const elem_type flip = value ? 0 : -1;
+  size_t idx, last_idx;
+  elem_type bits;
+
+  if (start >= end)
+    return end;
+
+  /* Turn the bits we are looking for into 1s, ignoring those in
+     the first element that come before START. */
+  idx = elem_idx (start);
+  last_idx = elem_idx (end - 1);
+  bits = (b->bits[idx] ^ flip) & ~(bit_mask (start) - 1);
+  while (bits == 0)
+    {
+      if (++idx > last_idx)
+        return end;
+      bits = b->bits[idx] ^ flip;
+    }
+
+  start = idx * ELEM_BITS + __builtin_ctzl (bits);
+  return start < end ? start : end;
+}
 
 /* Creation and destruction. */
 
@@ -83,6 +138,7 @@ bitmap_create (size_t bit_cnt)
     {
       b->bit_cnt = bit_cnt;
       b->bits = malloc (byte_cnt (bit_cnt));
+      b->next_fit = 0;
       if (b->bits != NULL || bit_cnt == 0)
         {
           bitmap_set_all (b, false);
@@ -105,6 +161,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  b->next_fit = 0;
   bitmap_set_all (b, false);
   return b;
 }
@@ -213,18 +270,32 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, a whole element at a
+   time. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
+  size_t end = start + cnt;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  while (start < end)
+    {
+      size_t ofs = start % ELEM_BITS;
+      size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+      elem_type *elem = &b->bits[elem_idx (start)];
+      elem_type mask = range_mask (ofs, n);
+
+      /* See bitmap_mark() and bitmap_reset(). */
+      if (value)
+        asm ("orl %1, %0" : "=m" (*elem) : "r" (mask) : "cc");
+      else
+        asm ("andl %1, %0" : "=m" (*elem) : "r" (~mask) : "cc");
+      start += n;
+    }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -232,17 +303,21 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i, value_cnt;
+  size_t end = start + cnt;
+  size_t ones = 0;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
-  return value_cnt;
+  while (start < end)
+    {
+      size_t ofs = start % ELEM_BITS;
+      size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+      ones += count_ones (b->bits[elem_idx (start)] & range_mask (ofs, n));
+      start += n;
+    }
+  return value ? ones : cnt - ones;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -250,16 +325,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_bit (b, start, start + cnt, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -298,13 +368,28 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
+  if (cnt == 0)
+    return start;
   if (cnt <= b->bit_cnt) 
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t i = start;
+
+      /* Jump to the next bit set to VALUE, then check whether the
+         run starting there is long enough.  If not, resume the
+         search just past the bit that cut it short. */
+      for (;;)
+        {
+          size_t stop;
+
+          i = find_bit (b, i, b->bit_cnt, value);
+          if (i > last)
+            break;
+          stop = find_bit (b, i, i + cnt, !value);
+          if (stop == i + cnt)
+            return i;
+          i = stop + 1;
+        }
     }
   return BITMAP_ERROR;
 }
@@ -324,6 +409,25 @@ bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value)
     bitmap_set_multiple (b, idx, cnt, !value);
   return idx;
 }
+
+/* Like bitmap_scan_and_flip(), but "next fit": starts looking
+   just past the group found by the previous call, wrapping
+   around to the beginning of B, instead of always at the
+   beginning.  This avoids rescanning the densely used front of
+   B on every call. */
+size_t
+bitmap_scan_and_flip_next (struct bitmap *b, size_t cnt, bool value)
+{
+  size_t idx = bitmap_scan (b, b->next_fit, cnt, value);
+  if (idx == BITMAP_ERROR && b->next_fit > 0)
+    idx = bitmap_scan (b, 0, cnt, value);
+  if (idx != BITMAP_ERROR) 
+    {
+      bitmap_set_multiple (b, idx, cnt, !value);
+      b->next_fit = idx + cnt;
+    }
+  return idx;
+}
 
 /* File input and output. */
 
@@ -0,0 +1,385 @@
+/* Open-addressed hash table.
+
+   See ohash.h for basic information. */
+
+#include "ohash.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* Initial number of slots in a table. */
+#define MIN_SLOTS 8
+
+/* The table grows when more than LOAD_NUM / LOAD_DEN of its
+   slots are in use.  Robin Hood probing keeps lookups fast up to
+   quite high loads. */
+#define LOAD_NUM 7
+#define LOAD_DEN 8
+
+static size_t find_slot (struct ohash *, struct ohash_elem *, unsigned hash);
+static void place_elem (struct ohash *, struct ohash_elem *, unsigned hash);
+static void remove_slot (struct ohash *, size_t idx);
+static void reserve (struct ohash *);
+static bool grow (struct ohash *);
+
+/* Initializes hash table H to compute hash values using HASH and
+   compare hash elements using LESS, given auxiliary data AUX.
+   Returns false if memory is not available. */
+bool
+ohash_init (struct ohash *h,
+            ohash_hash_func *hash, ohash_less_func *less, void *aux)
+{
+  h->elem_cnt = 0;
+  h->slot_cnt = MIN_SLOTS;
+  h->slots = malloc (sizeof *h->slots * h->slot_cnt);
+  h->hash = hash;
+  h->less = less;
+  h->aux = aux;
+
+  if (h->slots != NULL)
+    {
+      ohash_clear (h, NULL);
+      return true;
+    }
+  else
+    return false;
+}
+
+/* Removes all the elements from H.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the hash.  DESTRUCTOR may, if appropriate, deallocate the
+   memory used by the hash element.  However, modifying hash
+   table H while ohash_clear() is running, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), ohash_delete(), or ohash_remove(), yields
+   undefined behavior, whether done in DESTRUCTOR or elsewhere. */
+void
+ohash_clear (struct ohash *h, ohash_action_func *destructor)
+{
+  size_t i;
+
+  for (i = 0; i < h->slot_cnt; i++)
+    {
+      struct ohash_elem *e = h->slots[i].elem;
+
+      h->slots[i].elem = NULL;
+      if (e != NULL && destructor != NULL)
+        destructor (e, h->aux);
+    }
+
+  h->elem_cnt = 0;
+}
+
+/* Destroys hash table H.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the hash, as in ohash_clear(). */
+void
+ohash_destroy (struct ohash *h, ohash_action_func *destructor)
+{
+  if (destructor != NULL)
+    ohash_clear (h, destructor);
+  free (h->slots);
+}
+
+/* Inserts NEW into hash table H and returns a null pointer, if
+   no equal element is already in the table.
+   If an equal element is already in the table, returns it
+   without inserting NEW. */
+struct ohash_elem *
+ohash_insert (struct ohash *h, struct ohash_elem *new)
+{
+  unsigned hash = h->hash (new, h->aux);
+  size_t idx = find_slot (h, new, hash);
+
+  if (idx != SIZE_MAX)
+    return h->slots[idx].elem;
+
+  reserve (h);
+  place_elem (h, new, hash);
+  return NULL;
+}
+
+/* Inserts NEW into hash table H, replacing any equal element
+   already in the table, which is returned. */
+struct ohash_elem *
+ohash_replace (struct ohash *h, struct ohash_elem *new)
+{
+  unsigned hash = h->hash (new, h->aux);
+  size_t idx = find_slot (h, new, hash);
+
+  if (idx != SIZE_MAX)
+    {
+      struct ohash_elem *old = h->slots[idx].elem;
+      h->slots[idx].elem = new;
+      new->slot = idx;
+      return old;
+    }
+
+  reserve (h);
+  place_elem (h, new, hash);
+  return NULL;
+}
+
+/* Finds and returns an element equal to E in hash table H, or a
+   null pointer if no equal element exists in the table. */
+struct ohash_elem *
+ohash_find (struct ohash *h, struct ohash_elem *e)
+{
+  size_t idx = find_slot (h, e, h->hash (e, h->aux));
+  return idx != SIZE_MAX ? h->slots[idx].elem : NULL;
+}
+
+/* Finds, removes, and returns an element equal to E in hash
+   table H.  Returns a null pointer if no equal element existed
+   in the table.
+
+   If the elements of the hash table are dynamically allocated,
+   or own resources that are, then it is the caller's
+   responsibility to deallocate them. */
+struct ohash_elem *
+ohash_delete (struct ohash *h, struct ohash_elem *e)
+{
+  size_t idx = find_slot (h, e, h->hash (e, h->aux));
+  struct ohash_elem *found = NULL;
+
+  if (idx != SIZE_MAX)
+    {
+      found = h->slots[idx].elem;
+      remove_slot (h, idx);
+    }
+  return found;
+}
+
+/* Removes E, which must be in hash table H, from H.  Unlike
+   ohash_delete(), this neither hashes nor compares E. */
+void
+ohash_remove (struct ohash *h, struct ohash_elem *e)
+{
+  ASSERT (e->slot < h->slot_cnt);
+  ASSERT (h->slots[e->slot].elem == e);
+
+  remove_slot (h, e->slot);
+}
+
+/* Calls ACTION for each element in hash table H in arbitrary
+   order.
+   Modifying hash table H while ohash_apply() is running, using
+   any of the functions ohash_clear(), ohash_destroy(),
+   ohash_insert(), ohash_replace(), ohash_delete(), or
+   ohash_remove(), yields undefined behavior, whether done from
+   ACTION or elsewhere. */
+void
+ohash_apply (struct ohash *h, ohash_action_func *action)
+{
+  size_t i;
+
+  ASSERT (action != NULL);
+
+  for (i = 0; i < h->slot_cnt; i++)
+    if (h->slots[i].elem != NULL)
+      action (h->slots[i].elem, h->aux);
+}
+
+/* Initializes I for iterating hash table H.
+
+   Iteration idiom:
+
+      struct ohash_iterator i;
+
+      ohash_first (&i, h);
+      while (ohash_next (&i))
+        {
+          struct foo *f = ohash_entry (ohash_cur (&i), struct foo, elem);
+          ...do something with f...
+        }
+
+   Modifying hash table H during iteration, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), ohash_delete(), or ohash_remove(),
+   invalidates all iterators. */
+void
+ohash_first (struct ohash_iterator *i, struct ohash *h)
+{
+  ASSERT (i != NULL);
+  ASSERT (h != NULL);
+
+  i->hash = h;
+  i->slot = SIZE_MAX;
+  i->elem = NULL;
+}
+
+/* Advances I to the next element in the hash table and returns
+   it.  Returns a null pointer if no elements are left.  Elements
+   are returned in arbitrary order. */
+struct ohash_elem *
+ohash_next (struct ohash_iterator *i)
+{
+  ASSERT (i != NULL);
+
+  i->elem = NULL;
+  while (++i->slot < i->hash->slot_cnt)
+    if (i->hash->slots[i->slot].elem != NULL)
+      {
+        i->elem = i->hash->slots[i->slot].elem;
+        break;
+      }
+  if (i->elem == NULL)
+    i->slot = i->hash->slot_cnt;
+
+  return i->elem;
+}
+
+/* Returns the current element in the hash table iteration, or a
+   null pointer at the end of the table.  Undefined behavior
+   after calling ohash_first() but before ohash_next(). */
+struct ohash_elem *
+ohash_cur (struct ohash_iterator *i)
+{
+  return i->elem;
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h)
+{
+  return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h)
+{
+  return h->elem_cnt == 0;
+}
+
+/* Returns how far slot IDX in H is from the home slot of an
+   element with hash value HASH. */
+static inline size_t
+probe_dist (const struct ohash *h, unsigned hash, size_t idx)
+{
+  return (idx - hash) & (h->slot_cnt - 1);
+}
+
+/* Returns the index of the slot in H holding an element equal to
+   E, whose hash value is HASH, or SIZE_MAX if there is none. */
+static size_t
+find_slot (struct ohash *h, struct ohash_elem *e, unsigned hash)
+{
+  size_t mask = h->slot_cnt - 1;
+  size_t idx = hash & mask;
+  size_t dist;
+
+  /* Any element in the table lies between its home slot and the
+     first empty slot, and no further from home than the element
+     it displaced, so the search can stop at either. */
+  for (dist = 0; ; dist++, idx = (idx + 1) & mask)
+    {
+      struct ohash_slot *s = &h->slots[idx];
+
+      if (s->elem == NULL || probe_dist (h, s->hash, idx) < dist)
+        return SIZE_MAX;
+      if (s->hash == hash
+          && !h->less (s->elem, e, h->aux) && !h->less (e, s->elem, h->aux))
+        return idx;
+    }
+}
+
+/* Adds E, whose hash value is HASH, to H, which must not already
+   contain an equal element and must have an empty slot. */
+static void
+place_elem (struct ohash *h, struct ohash_elem *e, unsigned hash)
+{
+  size_t mask = h->slot_cnt - 1;
+  size_t idx = hash & mask;
+  size_t dist;
+
+  h->elem_cnt++;
+  for (dist = 0; ; dist++, idx = (idx + 1) & mask)
+    {
+      struct ohash_slot *s = &h->slots[idx];
+      size_t s_dist;
+
+      if (s->elem == NULL)
+        {
+          s->hash = hash;
+          s->elem = e;
+          e->slot = idx;
+          return;
+        }
+
+      /* Take the slot from an element closer to home, then go on
+         to find a place for that element. */
+      s_dist = probe_dist (h, s->hash, idx);
+      if (s_dist < dist)
+        {
+          struct ohash_slot displaced = *s;
+          s->hash = hash;
+          s->elem = e;
+          e->slot = idx;
+          hash = displaced.hash;
+          e = displaced.elem;
+          dist = s_dist;
+        }
+    }
+}
+
+/* Removes the element in slot IDX of H, shifting back the
+   elements that follow it until one is in its home slot. */
+static void
+remove_slot (struct ohash *h, size_t idx)
+{
+  size_t mask = h->slot_cnt - 1;
+
+  for (;;)
+    {
+      size_t next = (idx + 1) & mask;
+      struct ohash_slot *s = &h->slots[next];
+
+      if (s->elem == NULL || probe_dist (h, s->hash, next) == 0)
+        break;
+      h->slots[idx] = *s;
+      h->slots[idx].elem->slot = idx;
+      idx = next;
+    }
+  h->slots[idx].elem = NULL;
+  h->elem_cnt--;
+}
+
+/* Makes room in H for one more element, growing the table if it
+   is too full.  The table always keeps at least one empty slot,
+   which bounds searches, so if it cannot grow when it needs that
+   slot, the kernel panics. */
+static void
+reserve (struct ohash *h)
+{
+  if ((h->elem_cnt + 1) * LOAD_DEN > h->slot_cnt * LOAD_NUM
+      && !grow (h) && h->elem_cnt + 1 >= h->slot_cnt)
+    PANIC ("ohash: out of memory");
+}
+
+/* Doubles the number of slots in H and reinserts its elements.
+   Returns false, leaving H unchanged, if memory is not
+   available. */
+static bool
+grow (struct ohash *h)
+{
+  struct ohash_slot *old_slots = h->slots;
+  size_t old_cnt = h->slot_cnt;
+  size_t i;
+
+  h->slots = malloc (sizeof *h->slots * old_cnt * 2);
+  if (h->slots == NULL)
+    {
+      h->slots = old_slots;
+      return false;
+    }
+  h->slot_cnt = old_cnt * 2;
+  ohash_clear (h, NULL);
+
+  for (i = 0; i < old_cnt; i++)
+    if (old_slots[i].elem != NULL)
+      place_elem (h, old_slots[i].elem, old_slots[i].hash);
+  free (old_slots);
+  return true;
+}
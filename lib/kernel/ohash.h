@@ -0,0 +1,109 @@
+#ifndef __LIB_KERNEL_OHASH_H
+#define __LIB_KERNEL_OHASH_H
+
+/* Open-addressed hash table.
+
+   This is an alternative to the chained hash table in hash.h,
+   with the same style of interface.  Instead of an array of
+   linked lists, the table is a single array of slots, each
+   holding a pointer to an element and that element's hash
+   value.  A lookup starts at the slot selected by the hash value
+   and scans forward, comparing cached hash values and calling
+   the comparison function only on a match, so it usually touches
+   a single cache line and no list nodes.
+
+   Collisions are resolved with "Robin Hood" linear probing: an
+   element being inserted takes the slot of any element that is
+   closer to its own home slot, which keeps probe sequences short
+   and lets an unsuccessful search stop early.  Deletion shifts
+   the following elements back rather than leaving tombstones.
+
+   Like struct hash, the table is intrusive: each structure that
+   can be in an ohash embeds a struct ohash_elem, and ohash_entry
+   converts back to the enclosing structure.  The slot array is
+   allocated with malloc() and grows as elements are added.  The
+   sample hash functions in hash.h work equally well here. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hash element. */
+struct ohash_elem
+  {
+    size_t slot;                /* Index of slot holding this element. */
+  };
+
+/* Converts pointer to hash element OHASH_ELEM into a pointer to
+   the structure that OHASH_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the hash element. */
+#define ohash_entry(OHASH_ELEM, STRUCT, MEMBER)                 \
+        ((STRUCT *) ((uint8_t *) &(OHASH_ELEM)->slot            \
+                     - offsetof (STRUCT, MEMBER.slot)))
+
+/* Computes and returns the hash value for hash element E, given
+   auxiliary data AUX. */
+typedef unsigned ohash_hash_func (const struct ohash_elem *e, void *aux);
+
+/* Compares the value of two hash elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool ohash_less_func (const struct ohash_elem *a,
+                              const struct ohash_elem *b,
+                              void *aux);
+
+/* Performs some operation on hash element E, given auxiliary
+   data AUX. */
+typedef void ohash_action_func (struct ohash_elem *e, void *aux);
+
+/* A slot in an open-addressed hash table. */
+struct ohash_slot
+  {
+    unsigned hash;              /* Hash value of `elem'. */
+    struct ohash_elem *elem;    /* Element, or null if slot is empty. */
+  };
+
+/* Open-addressed hash table. */
+struct ohash
+  {
+    size_t elem_cnt;            /* Number of elements in table. */
+    size_t slot_cnt;            /* Number of slots, a power of 2. */
+    struct ohash_slot *slots;   /* Array of `slot_cnt' slots. */
+    ohash_hash_func *hash;      /* Hash function. */
+    ohash_less_func *less;      /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `hash' and `less'. */
+  };
+
+/* An open-addressed hash table iterator. */
+struct ohash_iterator
+  {
+    struct ohash *hash;         /* The hash table. */
+    size_t slot;                /* Current slot. */
+    struct ohash_elem *elem;    /* Current hash element. */
+  };
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *, ohash_hash_func *, ohash_less_func *,
+                 void *aux);
+void ohash_clear (struct ohash *, ohash_action_func *);
+void ohash_destroy (struct ohash *, ohash_action_func *);
+
+/* Search, insertion, deletion. */
+struct ohash_elem *ohash_insert (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_replace (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_find (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_delete (struct ohash *, struct ohash_elem *);
+void ohash_remove (struct ohash *, struct ohash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, ohash_action_func *);
+void ohash_first (struct ohash_iterator *, struct ohash *);
+struct ohash_elem *ohash_next (struct ohash_iterator *);
+struct ohash_elem *ohash_cur (struct ohash_iterator *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
+#endif /* lib/kernel/ohash.h */
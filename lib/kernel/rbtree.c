@@ -0,0 +1,437 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.
+
+   The tree maintains the usual red-black invariants, which keep
+   its height within twice the logarithm of its size:
+
+      - The root is black.
+
+      - A red node has no red children.
+
+      - Every path from a node down to a null child passes
+        through the same number of black nodes.
+
+   Null children count as black.  The insertion and deletion
+   fix-ups below follow Cormen, Leiserson, Rivest, and Stein,
+   "Introduction to Algorithms", adapted to null leaves. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static void rotate_left (struct rbtree *, struct rb_elem *);
+static void rotate_right (struct rbtree *, struct rb_elem *);
+static void replace_child (struct rbtree *, struct rb_elem *old,
+                           struct rb_elem *new);
+static void insert_fixup (struct rbtree *, struct rb_elem *);
+static void remove_fixup (struct rbtree *, struct rb_elem *,
+                          struct rb_elem *parent);
+
+/* Returns true if E is a red node, false if it is black or
+   null. */
+static inline bool
+is_red (const struct rb_elem *e)
+{
+  return e != NULL && e->red;
+}
+
+/* Initializes T as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rbtree *t, rb_less_func *less, void *aux)
+{
+  ASSERT (t != NULL);
+  ASSERT (less != NULL);
+
+  t->root = NULL;
+  t->elem_cnt = 0;
+  t->less = less;
+  t->aux = aux;
+}
+
+/* Inserts E into T, after any elements equal to it. */
+void
+rb_insert (struct rbtree *t, struct rb_elem *e)
+{
+  struct rb_elem *parent = NULL;
+  struct rb_elem **link = &t->root;
+
+  ASSERT (e != NULL);
+
+  while (*link != NULL)
+    {
+      parent = *link;
+      link = t->less (e, parent, t->aux) ? &parent->left : &parent->right;
+    }
+
+  e->parent = parent;
+  e->left = e->right = NULL;
+  e->red = true;
+  *link = e;
+  t->elem_cnt++;
+
+  insert_fixup (t, e);
+}
+
+/* Removes E, which must be in T, from T. */
+void
+rb_remove (struct rbtree *t, struct rb_elem *e)
+{
+  struct rb_elem *child, *parent;
+  bool removed_red;
+
+  ASSERT (e != NULL);
+  ASSERT (t->elem_cnt > 0);
+
+  if (e->left == NULL || e->right == NULL)
+    {
+      /* E has at most one child, which takes its place. */
+      child = e->left != NULL ? e->left : e->right;
+      parent = e->parent;
+      removed_red = e->red;
+      if (child != NULL)
+        child->parent = parent;
+      replace_child (t, e, child);
+    }
+  else
+    {
+      /* E's successor NEXT, which has no left child, takes its
+         place, and NEXT's right child takes NEXT's place. */
+      struct rb_elem *next = e->right;
+      while (next->left != NULL)
+        next = next->left;
+
+      child = next->right;
+      removed_red = next->red;
+      if (next->parent == e)
+        parent = next;
+      else
+        {
+          parent = next->parent;
+          parent->left = child;
+          if (child != NULL)
+            child->parent = parent;
+          next->right = e->right;
+          next->right->parent = next;
+        }
+      next->left = e->left;
+      next->left->parent = next;
+      next->parent = e->parent;
+      next->red = e->red;
+      replace_child (t, e, next);
+    }
+  t->elem_cnt--;
+
+  if (!removed_red)
+    remove_fixup (t, child, parent);
+}
+
+/* Returns the first element in T equal to E, or a null pointer
+   if there is none. */
+struct rb_elem *
+rb_find (struct rbtree *t, const struct rb_elem *e)
+{
+  struct rb_elem *found = rb_lower_bound (t, e);
+  return found != NULL && !t->less (e, found, t->aux) ? found : NULL;
+}
+
+/* Returns the first element in T that is not less than E, or a
+   null pointer if there is none. */
+struct rb_elem *
+rb_lower_bound (struct rbtree *t, const struct rb_elem *e)
+{
+  struct rb_elem *node = t->root;
+  struct rb_elem *bound = NULL;
+
+  while (node != NULL)
+    if (t->less (node, e, t->aux))
+      node = node->right;
+    else
+      {
+        bound = node;
+        node = node->left;
+      }
+  return bound;
+}
+
+/* Returns the first element in T that is greater than E, or a
+   null pointer if there is none. */
+struct rb_elem *
+rb_upper_bound (struct rbtree *t, const struct rb_elem *e)
+{
+  struct rb_elem *node = t->root;
+  struct rb_elem *bound = NULL;
+
+  while (node != NULL)
+    if (t->less (e, node, t->aux))
+      {
+        bound = node;
+        node = node->left;
+      }
+    else
+      node = node->right;
+  return bound;
+}
+
+/* Returns the least element in T, or a null pointer if T is
+   empty. */
+struct rb_elem *
+rb_min (struct rbtree *t)
+{
+  struct rb_elem *e = t->root;
+  if (e != NULL)
+    while (e->left != NULL)
+      e = e->left;
+  return e;
+}
+
+/* Returns the greatest element in T, or a null pointer if T is
+   empty. */
+struct rb_elem *
+rb_max (struct rbtree *t)
+{
+  struct rb_elem *e = t->root;
+  if (e != NULL)
+    while (e->right != NULL)
+      e = e->right;
+  return e;
+}
+
+/* Returns the element that follows E in its tree, or a null
+   pointer if E is the greatest element. */
+struct rb_elem *
+rb_next (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->right != NULL)
+    {
+      e = e->right;
+      while (e->left != NULL)
+        e = e->left;
+      return e;
+    }
+  while (e->parent != NULL && e == e->parent->right)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the element that precedes E in its tree, or a null
+   pointer if E is the least element. */
+struct rb_elem *
+rb_prev (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->left != NULL)
+    {
+      e = e->left;
+      while (e->right != NULL)
+        e = e->right;
+      return e;
+    }
+  while (e->parent != NULL && e == e->parent->left)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the number of elements in T. */
+size_t
+rb_size (struct rbtree *t)
+{
+  return t->elem_cnt;
+}
+
+/* Returns true if T is empty, false otherwise. */
+bool
+rb_empty (struct rbtree *t)
+{
+  return t->root == NULL;
+}
+
+/* Makes NEW take OLD's place as a child of OLD's parent, or as
+   the root of T.  Does not update NEW's parent pointer. */
+static void
+replace_child (struct rbtree *t, struct rb_elem *old, struct rb_elem *new)
+{
+  struct rb_elem *parent = old->parent;
+
+  if (parent == NULL)
+    t->root = new;
+  else if (parent->left == old)
+    parent->left = new;
+  else
+    parent->right = new;
+}
+
+/* Rotates the subtree rooted at E to the left, so that E's right
+   child takes E's place and E becomes its left child. */
+static void
+rotate_left (struct rbtree *t, struct rb_elem *e)
+{
+  struct rb_elem *r = e->right;
+
+  e->right = r->left;
+  if (r->left != NULL)
+    r->left->parent = e;
+  r->parent = e->parent;
+  replace_child (t, e, r);
+  r->left = e;
+  e->parent = r;
+}
+
+/* Rotates the subtree rooted at E to the right, so that E's left
+   child takes E's place and E becomes its right child. */
+static void
+rotate_right (struct rbtree *t, struct rb_elem *e)
+{
+  struct rb_elem *l = e->left;
+
+  e->left = l->right;
+  if (l->right != NULL)
+    l->right->parent = e;
+  l->parent = e->parent;
+  replace_child (t, e, l);
+  l->right = e;
+  e->parent = l;
+}
+
+/* Restores the red-black invariants after red node E is added
+   to T. */
+static void
+insert_fixup (struct rbtree *t, struct rb_elem *e)
+{
+  struct rb_elem *parent;
+
+  while ((parent = e->parent) != NULL && parent->red)
+    {
+      /* PARENT is red, so it is not the root. */
+      struct rb_elem *grandparent = parent->parent;
+
+      if (parent == grandparent->left)
+        {
+          struct rb_elem *uncle = grandparent->right;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+            }
+          else
+            {
+              if (e == parent->right)
+                {
+                  rotate_left (t, parent);
+                  parent = e;
+                }
+              parent->red = false;
+              grandparent->red = true;
+              rotate_right (t, grandparent);
+              break;
+            }
+        }
+      else
+        {
+          struct rb_elem *uncle = grandparent->left;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+            }
+          else
+            {
+              if (e == parent->left)
+                {
+                  rotate_right (t, parent);
+                  parent = e;
+                }
+              parent->red = false;
+              grandparent->red = true;
+              rotate_left (t, grandparent);
+              break;
+            }
+        }
+    }
+  t->root->red = false;
+}
+
+/* Restores the red-black invariants after a black node is
+   removed from T.  E, which may be null, is the node that took
+   its place, and PARENT is E's parent.  E's subtree is short one
+   black node. */
+static void
+remove_fixup (struct rbtree *t, struct rb_elem *e, struct rb_elem *parent)
+{
+  while (e != t->root && !is_red (e))
+    {
+      /* E's sibling has a black height of at least one, so it is
+         not null. */
+      if (e == parent->left)
+        {
+          struct rb_elem *sibling = parent->right;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_left (t, parent);
+              sibling = parent->right;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->right))
+                {
+                  sibling->left->red = false;
+                  sibling->red = true;
+                  rotate_right (t, sibling);
+                  sibling = parent->right;
+                }
+              sibling->red = parent->red;
+              parent->red = false;
+              sibling->right->red = false;
+              rotate_left (t, parent);
+              e = t->root;
+            }
+        }
+      else
+        {
+          struct rb_elem *sibling = parent->left;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_right (t, parent);
+              sibling = parent->left;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->left))
+                {
+                  sibling->right->red = false;
+                  sibling->red = true;
+                  rotate_left (t, sibling);
+                  sibling = parent->left;
+                }
+              sibling->red = parent->red;
+              parent->red = false;
+              sibling->left->red = false;
+              rotate_right (t, parent);
+              e = t->root;
+            }
+        }
+    }
+  if (e != NULL)
+    e->red = false;
+}
@@ -0,0 +1,98 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+
+   An ordered container with O(log n) insertion, deletion, and
+   search, for uses where list_insert_ordered() would take linear
+   time: timers ordered by wakeup tick, free extents ordered by
+   size, memory regions ordered by address, and the like.
+
+   Like the linked list in list.h, the tree does not allocate
+   memory.  Each structure that can be in a tree embeds a struct
+   rb_elem member, and the rb_entry macro converts a struct
+   rb_elem back to the structure that contains it.  Elements are
+   ordered by a caller-supplied "less" function.  Equal elements
+   are allowed; they are kept in insertion order.
+
+   In-order iteration:
+
+      struct rb_elem *e;
+
+      for (e = rb_min (&tree); e != NULL; e = rb_next (e))
+        {
+          struct foo *f = rb_entry (e, struct foo, elem);
+          ...do something with f...
+        }
+
+   Range query, visiting every element E with LO <= E < HI, where
+   LO and HI are elements (often stack-allocated keys) that need
+   not be in the tree:
+
+      for (e = rb_lower_bound (&tree, &lo.elem);
+           e != NULL && tree.less (e, &hi.elem, tree.aux);
+           e = rb_next (e))
+        ...
+
+   Removing the current element with rb_remove() invalidates it,
+   so fetch rb_next() first if iteration is to continue. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree element. */
+struct rb_elem
+  {
+    struct rb_elem *parent;     /* Parent, or null at the root. */
+    struct rb_elem *left;       /* Lesser subtree. */
+    struct rb_elem *right;      /* Greater-or-equal subtree. */
+    bool red;                   /* Red node?  Otherwise black. */
+  };
+
+/* Converts pointer to tree element RB_ELEM into a pointer to
+   the structure that RB_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the tree element. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER)                       \
+        ((STRUCT *) ((uint8_t *) &(RB_ELEM)->parent             \
+                     - offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_elem *a,
+                           const struct rb_elem *b,
+                           void *aux);
+
+/* Red-black tree. */
+struct rbtree
+  {
+    struct rb_elem *root;       /* Root, or null if tree is empty. */
+    size_t elem_cnt;            /* Number of elements. */
+    rb_less_func *less;         /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+void rb_init (struct rbtree *, rb_less_func *, void *aux);
+
+/* Insertion and removal. */
+void rb_insert (struct rbtree *, struct rb_elem *);
+void rb_remove (struct rbtree *, struct rb_elem *);
+
+/* Search. */
+struct rb_elem *rb_find (struct rbtree *, const struct rb_elem *);
+struct rb_elem *rb_lower_bound (struct rbtree *, const struct rb_elem *);
+struct rb_elem *rb_upper_bound (struct rbtree *, const struct rb_elem *);
+
+/* Ordered traversal. */
+struct rb_elem *rb_min (struct rbtree *);
+struct rb_elem *rb_max (struct rbtree *);
+struct rb_elem *rb_next (struct rb_elem *);
+struct rb_elem *rb_prev (struct rb_elem *);
+
+/* Information. */
+size_t rb_size (struct rbtree *);
+bool rb_empty (struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
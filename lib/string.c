@@ -1,5 +1,62 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* The block memory functions below run in both the kernel and
+   user programs, so they cannot use SSE or other FPU state: the
+   kernel sets CR0.EM and does not save FPU registers across
+   context switches.  Instead they move 32-bit words with the x86
+   string instructions, handling the odd bytes separately.  The
+   direction flag is clear on entry to both kernel and user code,
+   so forward string instructions need no CLD. */
+
+/* A 32-bit word that may alias any other type. */
+typedef uint32_t __attribute__ ((__may_alias__)) word_t;
+
+/* Copies SIZE bytes from SRC to DST, lowest address first. */
+static inline void
+copy_up (unsigned char *dst, const unsigned char *src, size_t size)
+{
+  int ecx, edi, esi;
+
+  /* Word-align DST, since misaligned stores cost more than
+     misaligned loads. */
+  if (size >= 16)
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      asm volatile ("rep movsb"
+                    : "=&c" (ecx), "=&D" (dst), "=&S" (src)
+                    : "0" (head), "1" (dst), "2" (src)
+                    : "memory");
+      size -= head;
+    }
+
+  asm volatile ("rep movsl\n\t"
+                "movl %3, %%ecx\n\t"
+                "rep movsb"
+                : "=&c" (ecx), "=&D" (edi), "=&S" (esi)
+                : "rm" (size & 3), "0" (size / 4), "1" (dst), "2" (src)
+                : "memory");
+}
+
+/* Copies SIZE bytes from SRC to DST, highest address first. */
+static inline void
+copy_down (unsigned char *dst, const unsigned char *src, size_t size)
+{
+  int ecx, edi, esi;
+
+  asm volatile ("std\n\t"
+                "rep movsb\n\t"
+                "subl $3, %%esi\n\t"
+                "subl $3, %%edi\n\t"
+                "movl %3, %%ecx\n\t"
+                "rep movsl\n\t"
+                "cld"
+                : "=&c" (ecx), "=&D" (edi), "=&S" (esi)
+                : "rm" (size / 4), "0" (size & 3),
+                  "1" (dst + size - 1), "2" (src + size - 1)
+                : "memory");
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,8 +69,7 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = *src++;
+  copy_up (dst, src, size);
 
   return dst_;
 }
@@ -29,20 +85,12 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src) 
-    {
-      while (size-- > 0)
-        *dst++ = *src++;
-    }
-  else 
-    {
-      dst += size;
-      src += size;
-      while (size-- > 0)
-        *--dst = *--src;
-    }
+  if (dst <= src || dst >= src + size)
+    copy_up (dst, src, size);
+  else
+    copy_down (dst, src, size);
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +106,10 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words, then find the differing byte. */
+  for (; size >= 4; a += 4, b += 4, size -= 4)
+    if (*(const word_t *) a != *(const word_t *) b)
+      break;
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -279,11 +331,27 @@ void *
 memset (void *dst_, int value, size_t size) 
 {
   unsigned char *dst = dst_;
+  uint32_t word = (unsigned char) value * 0x01010101u;
+  int ecx, edi;
 
   ASSERT (dst != NULL || size == 0);
-  
-  while (size-- > 0)
-    *dst++ = value;
+
+  if (size >= 16)
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      asm volatile ("rep stosb"
+                    : "=&c" (ecx), "=&D" (dst)
+                    : "0" (head), "1" (dst), "a" (word)
+                    : "memory");
+      size -= head;
+    }
+
+  asm volatile ("rep stosl\n\t"
+                "movl %2, %%ecx\n\t"
+                "rep stosb"
+                : "=&c" (ecx), "=&D" (edi)
+                : "rm" (size & 3), "0" (size / 4), "1" (dst), "a" (word)
+                : "memory");
 
   return dst_;
 }
@@ -0,0 +1,17 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* One buffer in a vectored read or write, as passed to the readv
+   and writev system calls. */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Number of bytes in buffer. */
+  };
+
+/* Most buffers that one readv or writev may be given. */
+#define IOV_MAX 64
+
+#endif /* lib/uio.h */
@@ -0,0 +1,135 @@
+#include <syscall.h>
+#include <string.h>
+#include "../syscall-nr.h"
+
+/* Initializes RING as empty and registers it with the kernel.
+   Returns true if successful, false otherwise. */
+bool
+batch_init (struct batch_ring *ring)
+{
+  memset (ring, 0, sizeof *ring);
+  return batch_setup (ring);
+}
+
+/* Queues system call NR with the given arguments and TAG in
+   RING's submission queue.  Returns true if successful, false if
+   the queue is full. */
+static bool
+queue (struct batch_ring *ring, uint32_t tag, int nr,
+       uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+  struct batch_sqe *sqe;
+
+  if (ring->sq_tail - ring->sq_head >= BATCH_RING_SIZE)
+    return false;
+
+  sqe = &ring->sq[ring->sq_tail % BATCH_RING_SIZE];
+  sqe->nr = nr;
+  sqe->args[0] = arg0;
+  sqe->args[1] = arg1;
+  sqe->args[2] = arg2;
+  sqe->args[3] = arg3;
+  sqe->tag = tag;
+
+  /* Make sure the entry is complete before the kernel can see
+     it. */
+  asm volatile ("" : : : "memory");
+  ring->sq_tail++;
+  return true;
+}
+
+bool
+batch_create (struct batch_ring *ring, uint32_t tag,
+              const char *file, unsigned initial_size)
+{
+  return queue (ring, tag, SYS_CREATE, (uint32_t) file, initial_size, 0, 0);
+}
+
+bool
+batch_remove (struct batch_ring *ring, uint32_t tag, const char *file)
+{
+  return queue (ring, tag, SYS_REMOVE, (uint32_t) file, 0, 0, 0);
+}
+
+bool
+batch_open (struct batch_ring *ring, uint32_t tag, const char *file)
+{
+  return queue (ring, tag, SYS_OPEN, (uint32_t) file, 0, 0, 0);
+}
+
+bool
+batch_close (struct batch_ring *ring, uint32_t tag, int fd)
+{
+  return queue (ring, tag, SYS_CLOSE, fd, 0, 0, 0);
+}
+
+bool
+batch_filesize (struct batch_ring *ring, uint32_t tag, int fd)
+{
+  return queue (ring, tag, SYS_FILESIZE, fd, 0, 0, 0);
+}
+
+bool
+batch_read (struct batch_ring *ring, uint32_t tag,
+            int fd, void *buffer, unsigned size)
+{
+  return queue (ring, tag, SYS_READ, fd, (uint32_t) buffer, size, 0);
+}
+
+bool
+batch_write (struct batch_ring *ring, uint32_t tag,
+             int fd, const void *buffer, unsigned size)
+{
+  return queue (ring, tag, SYS_WRITE, fd, (uint32_t) buffer, size, 0);
+}
+
+bool
+batch_seek (struct batch_ring *ring, uint32_t tag,
+            int fd, unsigned position)
+{
+  return queue (ring, tag, SYS_SEEK, fd, position, 0, 0);
+}
+
+bool
+batch_tell (struct batch_ring *ring, uint32_t tag, int fd)
+{
+  return queue (ring, tag, SYS_TELL, fd, 0, 0, 0);
+}
+
+bool
+batch_pread (struct batch_ring *ring, uint32_t tag,
+             int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return queue (ring, tag, SYS_PREAD, fd, (uint32_t) buffer, size, offset);
+}
+
+bool
+batch_pwrite (struct batch_ring *ring, uint32_t tag, int fd,
+              const void *buffer, unsigned size, unsigned offset)
+{
+  return queue (ring, tag, SYS_PWRITE, fd, (uint32_t) buffer, size, offset);
+}
+
+/* Has the kernel carry out all the calls queued in RING, as far
+   as there is room for their results, and returns the number
+   carried out. */
+int
+batch_submit (struct batch_ring *ring UNUSED)
+{
+  return batch_enter ();
+}
+
+/* Takes the oldest result from RING's completion queue into
+   *CQE.  Returns true if successful, false if there are no
+   results. */
+bool
+batch_reap (struct batch_ring *ring, struct batch_cqe *cqe)
+{
+  if (ring->cq_head == ring->cq_tail)
+    return false;
+
+  *cqe = ring->cq[ring->cq_head % BATCH_RING_SIZE];
+  asm volatile ("" : : : "memory");
+  ring->cq_head++;
+  return true;
+}
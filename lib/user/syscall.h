@@ -2,7 +2,10 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <batch.h>
 #include <debug.h>
+#include <uio.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +48,38 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+pid_t fork (void);
+void vmstat (struct vmstat *);
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int copy_file_range (int fd_in, int fd_out, unsigned length);
+bool batch_setup (struct batch_ring *);
+int batch_enter (void);
+
+/* Batched system calls, through a ring set up by batch_init().
+   See lib/batch.h. */
+bool batch_init (struct batch_ring *);
+bool batch_create (struct batch_ring *, uint32_t tag,
+                   const char *file, unsigned initial_size);
+bool batch_remove (struct batch_ring *, uint32_t tag, const char *file);
+bool batch_open (struct batch_ring *, uint32_t tag, const char *file);
+bool batch_close (struct batch_ring *, uint32_t tag, int fd);
+bool batch_filesize (struct batch_ring *, uint32_t tag, int fd);
+bool batch_read (struct batch_ring *, uint32_t tag,
+                 int fd, void *buffer, unsigned length);
+bool batch_write (struct batch_ring *, uint32_t tag,
+                  int fd, const void *buffer, unsigned length);
+bool batch_seek (struct batch_ring *, uint32_t tag,
+                 int fd, unsigned position);
+bool batch_tell (struct batch_ring *, uint32_t tag, int fd);
+bool batch_pread (struct batch_ring *, uint32_t tag,
+                  int fd, void *buffer, unsigned length, unsigned offset);
+bool batch_pwrite (struct batch_ring *, uint32_t tag, int fd,
+                   const void *buffer, unsigned length, unsigned offset);
+int batch_submit (struct batch_ring *);
+bool batch_reap (struct batch_ring *, struct batch_cqe *);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,18 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+#include <stdint.h>
+
+/* Virtual memory statistics for a single process, as kept by the
+   kernel and reported by the vmstat system call. */
+struct vmstat
+  {
+    unsigned minor_faults;      /* Faults resolved without I/O. */
+    unsigned major_faults;      /* Faults that had to read a page in. */
+    unsigned evictions;         /* Frames evicted to satisfy our faults. */
+    unsigned swap_ins;          /* Our pages read back from swap. */
+    unsigned swap_outs;         /* Our pages written out to swap. */
+    uint64_t fault_cycles;      /* Total CPU cycles spent in our faults. */
+  };
+
+#endif /* lib/vmstat.h */
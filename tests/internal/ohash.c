@@ -0,0 +1,223 @@
+/* Test program and benchmark for lib/kernel/ohash.c.
+
+   Checks the open-addressed hash table against a simple array
+   under a random mix of insertions and deletions, then times
+   insertion, successful and unsuccessful lookup, and deletion
+   in struct ohash and in the chained struct hash from
+   lib/kernel/hash.c, holding the same elements.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <inttypes.h>
+#include <ohash.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Number of elements in the benchmark tables. */
+#define ELEM_CNT 4096
+
+/* Number of random operations in the correctness check. */
+#define OP_CNT 100000
+
+/* An element that can be in both kinds of table. */
+struct value
+  {
+    struct hash_elem hash_elem;         /* Element in struct hash. */
+    struct ohash_elem ohash_elem;       /* Element in struct ohash. */
+    int key;                            /* Key. */
+    bool in_table;                      /* In the ohash under test? */
+  };
+
+static struct value values[2 * ELEM_CNT];
+
+static void check_ohash (void);
+static void time_tables (void);
+static unsigned value_ohash (const struct ohash_elem *, void *);
+static bool value_oless (const struct ohash_elem *,
+                         const struct ohash_elem *, void *);
+static unsigned value_hash (const struct hash_elem *, void *);
+static bool value_less (const struct hash_elem *, const struct hash_elem *,
+                        void *);
+static inline uint64_t read_tsc (void);
+
+/* Tests and times the open-addressed hash table. */
+void
+test (void)
+{
+  check_ohash ();
+  time_tables ();
+  printf ("ohash: PASS\n");
+}
+
+/* Applies random insertions and deletions to an ohash and checks
+   its contents after each one. */
+static void
+check_ohash (void)
+{
+  struct ohash h;
+  struct ohash_iterator i;
+  size_t cnt = 0, seen;
+  int op;
+
+  printf ("checking ohash:");
+  ASSERT (ohash_init (&h, value_ohash, value_oless, NULL));
+  for (op = 0; op < ELEM_CNT; op++)
+    {
+      values[op].key = op;
+      values[op].in_table = false;
+    }
+
+  for (op = 0; op < OP_CNT; op++)
+    {
+      struct value *v = &values[random_ulong () % ELEM_CNT];
+      struct value key;
+
+      key.key = v->key;
+      switch (random_ulong () % 3)
+        {
+        case 0:
+          ASSERT ((ohash_insert (&h, &v->ohash_elem) != NULL)
+                  == v->in_table);
+          if (!v->in_table)
+            cnt++;
+          v->in_table = true;
+          break;
+
+        case 1:
+          ASSERT (ohash_delete (&h, &key.ohash_elem)
+                  == (v->in_table ? &v->ohash_elem : NULL));
+          if (v->in_table)
+            cnt--;
+          v->in_table = false;
+          break;
+
+        case 2:
+          if (v->in_table)
+            {
+              ohash_remove (&h, &v->ohash_elem);
+              cnt--;
+            }
+          v->in_table = false;
+          break;
+        }
+
+      ASSERT (ohash_find (&h, &key.ohash_elem)
+              == (v->in_table ? &v->ohash_elem : NULL));
+      ASSERT (ohash_size (&h) == cnt);
+      if (op % (OP_CNT / 10) == 0)
+        printf (" %d", op);
+    }
+
+  seen = 0;
+  ohash_first (&i, &h);
+  while (ohash_next (&i))
+    {
+      struct value *v = ohash_entry (ohash_cur (&i), struct value,
+                                     ohash_elem);
+      ASSERT (v->in_table);
+      seen++;
+    }
+  ASSERT (seen == cnt);
+
+  ohash_destroy (&h, NULL);
+  printf (" done\n");
+}
+
+/* Prints the average number of cycles per operation for struct
+   hash and struct ohash, each holding ELEM_CNT elements. */
+static void
+time_tables (void)
+{
+  struct hash chained;
+  struct ohash open;
+  uint64_t start, cycles[8];
+  int i;
+
+  ASSERT (hash_init (&chained, value_hash, value_less, NULL));
+  ASSERT (ohash_init (&open, value_ohash, value_oless, NULL));
+  for (i = 0; i < 2 * ELEM_CNT; i++)
+    values[i].key = random_ulong () & ~1;
+  for (i = ELEM_CNT; i < 2 * ELEM_CNT; i++)
+    values[i].key |= 1;
+
+#define TIME(IDX, STMT)                                 \
+  start = read_tsc ();                                  \
+  for (i = 0; i < ELEM_CNT; i++)                        \
+    STMT;                                               \
+  cycles[IDX] = (read_tsc () - start) / ELEM_CNT;
+
+  /* Elements 0...ELEM_CNT-1 have even keys and go in the tables;
+     the rest have odd keys and are used for failed lookups.
+     Duplicate random keys make some insertions fail, equally in
+     both tables. */
+  TIME (0, hash_insert (&chained, &values[i].hash_elem));
+  TIME (1, ohash_insert (&open, &values[i].ohash_elem));
+  TIME (2, ASSERT (hash_find (&chained, &values[i].hash_elem) != NULL));
+  TIME (3, ASSERT (ohash_find (&open, &values[i].ohash_elem) != NULL));
+  TIME (4, ASSERT (hash_find (&chained, &values[i + ELEM_CNT].hash_elem)
+                   == NULL));
+  TIME (5, ASSERT (ohash_find (&open, &values[i + ELEM_CNT].ohash_elem)
+                   == NULL));
+  TIME (6, hash_delete (&chained, &values[i].hash_elem));
+  TIME (7, ohash_delete (&open, &values[i].ohash_elem));
+#undef TIME
+
+  ASSERT (hash_empty (&chained));
+  ASSERT (ohash_empty (&open));
+  hash_destroy (&chained, NULL);
+  ohash_destroy (&open, NULL);
+
+  printf ("cycles per operation, %d elements:\n", ELEM_CNT);
+  printf ("%-8s %8s %8s\n", "", "hash", "ohash");
+  printf ("%-8s %8"PRIu64" %8"PRIu64"\n", "insert", cycles[0], cycles[1]);
+  printf ("%-8s %8"PRIu64" %8"PRIu64"\n", "hit", cycles[2], cycles[3]);
+  printf ("%-8s %8"PRIu64" %8"PRIu64"\n", "miss", cycles[4], cycles[5]);
+  printf ("%-8s %8"PRIu64" %8"PRIu64"\n", "delete", cycles[6], cycles[7]);
+}
+
+/* Returns a hash of the key of the value containing E. */
+static unsigned
+value_ohash (const struct ohash_elem *e, void *aux UNUSED)
+{
+  return hash_int (ohash_entry (e, struct value, ohash_elem)->key);
+}
+
+/* Returns true if A's key is less than B's key. */
+static bool
+value_oless (const struct ohash_elem *a, const struct ohash_elem *b,
+             void *aux UNUSED)
+{
+  return (ohash_entry (a, struct value, ohash_elem)->key
+          < ohash_entry (b, struct value, ohash_elem)->key);
+}
+
+/* Returns a hash of the key of the value containing E. */
+static unsigned
+value_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct value, hash_elem)->key);
+}
+
+/* Returns true if A's key is less than B's key. */
+static bool
+value_less (const struct hash_elem *a, const struct hash_elem *b,
+            void *aux UNUSED)
+{
+  return (hash_entry (a, struct value, hash_elem)->key
+          < hash_entry (b, struct value, hash_elem)->key);
+}
+
+/* Returns the processor's time-stamp counter. */
+static inline uint64_t
+read_tsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
@@ -0,0 +1,202 @@
+/* Test program for lib/kernel/rbtree.c.
+
+   Applies random insertions and removals to a red-black tree,
+   checking the red-black invariants, in-order traversal in both
+   directions, and searches against a brute-force scan.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <rbtree.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Number of values that can be in the tree. */
+#define VALUE_CNT 1024
+
+/* Number of distinct keys, fewer than VALUE_CNT so that the tree
+   has plenty of equal elements. */
+#define KEY_CNT 256
+
+/* Number of random insertions and removals. */
+#define OP_CNT 50000
+
+/* A tree element. */
+struct value
+  {
+    struct rb_elem elem;        /* Tree element. */
+    int key;                    /* Sort key. */
+    int seq;                    /* Insertion sequence number. */
+    bool in_tree;               /* Currently in the tree? */
+  };
+
+static struct value values[VALUE_CNT];
+
+static bool value_less (const struct rb_elem *, const struct rb_elem *,
+                        void *);
+static int verify_subtree (struct rb_elem *, struct rb_elem *parent);
+static void verify_tree (struct rbtree *);
+static void verify_search (struct rbtree *, int key);
+
+/* Test the red-black tree implementation. */
+void
+test (void)
+{
+  struct rbtree tree;
+  int seq = 0;
+  int op;
+
+  printf ("testing red-black tree:");
+  rb_init (&tree, value_less, NULL);
+  for (op = 0; op < OP_CNT; op++)
+    {
+      struct value *v = &values[random_ulong () % VALUE_CNT];
+
+      if (!v->in_tree)
+        {
+          v->key = random_ulong () % KEY_CNT;
+          v->seq = seq++;
+          rb_insert (&tree, &v->elem);
+        }
+      else
+        rb_remove (&tree, &v->elem);
+      v->in_tree = !v->in_tree;
+
+      if (op % 100 == 0)
+        {
+          verify_tree (&tree);
+          verify_search (&tree,
+                         (int) (random_ulong () % (KEY_CNT + 2)) - 1);
+        }
+      if (op % (OP_CNT / 10) == 0)
+        printf (" %d", op);
+    }
+
+  /* Empty the tree in order. */
+  while (!rb_empty (&tree))
+    {
+      struct value *v = rb_entry (rb_min (&tree), struct value, elem);
+      rb_remove (&tree, &v->elem);
+      v->in_tree = false;
+    }
+  ASSERT (rb_size (&tree) == 0);
+  ASSERT (rb_max (&tree) == NULL);
+
+  printf (" done\n");
+  printf ("rbtree: PASS\n");
+}
+
+/* Orders values by key. */
+static bool
+value_less (const struct rb_elem *a_, const struct rb_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = rb_entry (a_, struct value, elem);
+  const struct value *b = rb_entry (b_, struct value, elem);
+
+  return a->key < b->key;
+}
+
+/* Checks the parent links and red-black invariants of the
+   subtree rooted at E, whose parent should be PARENT.  Returns
+   the subtree's black height. */
+static int
+verify_subtree (struct rb_elem *e, struct rb_elem *parent)
+{
+  int left_height, right_height;
+
+  if (e == NULL)
+    return 1;
+
+  ASSERT (e->parent == parent);
+  ASSERT (!e->red || ((e->left == NULL || !e->left->red)
+                       && (e->right == NULL || !e->right->red)));
+
+  left_height = verify_subtree (e->left, e);
+  right_height = verify_subtree (e->right, e);
+  ASSERT (left_height == right_height);
+  return left_height + !e->red;
+}
+
+/* Checks TREE's structure, and that traversing it forward and
+   backward visits exactly the values marked as in the tree, in
+   order, with equal keys in insertion order. */
+static void
+verify_tree (struct rbtree *tree)
+{
+  struct rb_elem *e;
+  size_t cnt, expected;
+  int i;
+
+  ASSERT (tree->root == NULL || !tree->root->red);
+  verify_subtree (tree->root, NULL);
+
+  expected = 0;
+  for (i = 0; i < VALUE_CNT; i++)
+    expected += values[i].in_tree;
+  ASSERT (rb_size (tree) == expected);
+
+  cnt = 0;
+  for (e = rb_min (tree); e != NULL; e = rb_next (e))
+    {
+      struct value *v = rb_entry (e, struct value, elem);
+      struct rb_elem *next = rb_next (e);
+
+      ASSERT (v->in_tree);
+      if (next != NULL)
+        {
+          struct value *w = rb_entry (next, struct value, elem);
+          ASSERT (v->key < w->key || (v->key == w->key && v->seq < w->seq));
+          ASSERT (rb_prev (next) == e);
+        }
+      cnt++;
+    }
+  ASSERT (cnt == expected);
+
+  cnt = 0;
+  for (e = rb_max (tree); e != NULL; e = rb_prev (e))
+    cnt++;
+  ASSERT (cnt == expected);
+}
+
+/* Checks rb_find(), rb_lower_bound(), and rb_upper_bound() for
+   KEY against a linear scan of TREE, and that the range of
+   elements between the bounds holds exactly the values with that
+   key. */
+static void
+verify_search (struct rbtree *tree, int key)
+{
+  struct value probe;
+  struct rb_elem *e, *lower = NULL, *upper = NULL;
+  int i, in_range, with_key;
+
+  probe.key = key;
+  for (e = rb_min (tree); e != NULL; e = rb_next (e))
+    {
+      int k = rb_entry (e, struct value, elem)->key;
+      if (lower == NULL && k >= key)
+        lower = e;
+      if (upper == NULL && k > key)
+        upper = e;
+    }
+
+  ASSERT (rb_lower_bound (tree, &probe.elem) == lower);
+  ASSERT (rb_upper_bound (tree, &probe.elem) == upper);
+  ASSERT (rb_find (tree, &probe.elem)
+          == (lower != NULL && lower != upper ? lower : NULL));
+
+  in_range = 0;
+  for (e = lower; e != upper; e = rb_next (e))
+    {
+      ASSERT (rb_entry (e, struct value, elem)->key == key);
+      in_range++;
+    }
+  with_key = 0;
+  for (i = 0; i < VALUE_CNT; i++)
+    with_key += values[i].in_tree && values[i].key == key;
+  ASSERT (in_range == with_key);
+}
@@ -0,0 +1,195 @@
+/* Test program and microbenchmark for the block memory
+   functions in lib/string.c.
+
+   Checks memcpy(), memmove(), memset(), and memcmp() against
+   simple byte-at-a-time versions for every combination of
+   source and destination alignment, then times both versions
+   on block sizes typical of Pintos: short strings, argument
+   copies, disk sectors, and pages.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/test.h"
+
+/* Size of the test buffers. */
+#define BUF_SIZE 8192
+
+/* Largest block checked for correctness. */
+#define MAX_CHECK 80
+
+/* Number of times each block size is timed. */
+#define ITERATIONS 2000
+
+static uint8_t src_buf[BUF_SIZE], dst_buf[BUF_SIZE], ref_buf[BUF_SIZE];
+
+static void check_functions (void);
+static void time_functions (void);
+static void byte_copy (uint8_t *, const uint8_t *, size_t);
+static void byte_set (uint8_t *, int, size_t);
+static int byte_compare (const uint8_t *, const uint8_t *, size_t);
+static inline uint64_t read_tsc (void);
+
+/* Tests and times the block memory functions. */
+void
+test (void)
+{
+  check_functions ();
+  time_functions ();
+  printf ("string: PASS\n");
+}
+
+/* Checks the block memory functions against the byte-wise
+   reference versions at every alignment. */
+static void
+check_functions (void)
+{
+  size_t src_ofs, dst_ofs, size;
+
+  printf ("checking block functions:");
+  for (size = 0; size <= MAX_CHECK; size++)
+    {
+      if (size % 8 == 0)
+        printf (" %zu", size);
+      for (src_ofs = 0; src_ofs < 8; src_ofs++)
+        for (dst_ofs = 0; dst_ofs < 8; dst_ofs++)
+          {
+            int value = random_ulong ();
+
+            /* memcpy(). */
+            random_bytes (src_buf, BUF_SIZE);
+            random_bytes (dst_buf, BUF_SIZE);
+            memcpy (ref_buf, dst_buf, BUF_SIZE);
+            ASSERT (memcpy (dst_buf + dst_ofs, src_buf + src_ofs, size)
+                    == dst_buf + dst_ofs);
+            byte_copy (ref_buf + dst_ofs, src_buf + src_ofs, size);
+            ASSERT (!byte_compare (dst_buf, ref_buf, BUF_SIZE));
+
+            /* memcmp(), on equal blocks and with one bit flipped. */
+            ASSERT (memcmp (dst_buf + dst_ofs, src_buf + src_ofs, size)
+                    == 0);
+            if (size > 0)
+              {
+                size_t ofs = random_ulong () % size;
+                int cmp;
+
+                dst_buf[dst_ofs + ofs] ^= 1 << random_ulong () % 8;
+                cmp = memcmp (dst_buf + dst_ofs, src_buf + src_ofs, size);
+                ASSERT (cmp != 0);
+                ASSERT ((cmp > 0) == (dst_buf[dst_ofs + ofs]
+                                      > src_buf[src_ofs + ofs]));
+              }
+
+            /* memmove(), within a single buffer in both directions. */
+            memcpy (ref_buf, src_buf, BUF_SIZE);
+            ASSERT (memmove (src_buf + dst_ofs, src_buf + src_ofs, size)
+                    == src_buf + dst_ofs);
+            if (dst_ofs < src_ofs)
+              byte_copy (ref_buf + dst_ofs, ref_buf + src_ofs, size);
+            else
+              {
+                size_t i;
+                for (i = size; i-- > 0; )
+                  ref_buf[dst_ofs + i] = ref_buf[src_ofs + i];
+              }
+            ASSERT (!byte_compare (src_buf, ref_buf, BUF_SIZE));
+
+            /* memset(). */
+            memcpy (ref_buf, dst_buf, BUF_SIZE);
+            ASSERT (memset (dst_buf + dst_ofs, value, size)
+                    == dst_buf + dst_ofs);
+            byte_set (ref_buf + dst_ofs, value, size);
+            ASSERT (!byte_compare (dst_buf, ref_buf, BUF_SIZE));
+          }
+    }
+  printf (" done\n");
+}
+
+/* Prints the average number of cycles taken by the block memory
+   functions and by the byte-wise versions for various sizes. */
+static void
+time_functions (void)
+{
+  static const size_t sizes[] = {8, 64, 512, 4096};
+  size_t i;
+
+  printf ("%6s %8s %8s %8s %8s %8s %8s\n", "size", "memcpy", "bytes",
+          "memset", "bytes", "memcmp", "bytes");
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    {
+      size_t size = sizes[i];
+      uint64_t start, cycles[6];
+      int j;
+
+      memset (src_buf, 0x5a, BUF_SIZE);
+      memset (dst_buf, 0x5a, BUF_SIZE);
+
+#define TIME(IDX, STMT)                                 \
+      start = read_tsc ();                              \
+      for (j = 0; j < ITERATIONS; j++)                  \
+        STMT;                                           \
+      cycles[IDX] = (read_tsc () - start) / ITERATIONS;
+
+      TIME (0, memcpy (dst_buf + 1, src_buf, size));
+      TIME (1, byte_copy (dst_buf + 1, src_buf, size));
+      TIME (2, memset (dst_buf, j, size));
+      TIME (3, byte_set (dst_buf, j, size));
+      memset (dst_buf, 0x5a, BUF_SIZE);
+      TIME (4, ASSERT (!memcmp (dst_buf, src_buf, size)));
+      TIME (5, ASSERT (!byte_compare (dst_buf, src_buf, size)));
+#undef TIME
+
+      printf ("%6zu %8"PRIu64" %8"PRIu64" %8"PRIu64" %8"PRIu64
+              " %8"PRIu64" %8"PRIu64"\n", size, cycles[0], cycles[1],
+              cycles[2], cycles[3], cycles[4], cycles[5]);
+    }
+}
+
+/* Copies SIZE bytes from SRC to DST one byte at a time.  The
+   volatile destination keeps the compiler from turning the loop
+   back into a call to memcpy(). */
+static void
+byte_copy (uint8_t *dst, const uint8_t *src, size_t size)
+{
+  volatile uint8_t *d = dst;
+  while (size-- > 0)
+    *d++ = *src++;
+}
+
+/* Sets SIZE bytes at DST to VALUE one byte at a time. */
+static void
+byte_set (uint8_t *dst, int value, size_t size)
+{
+  volatile uint8_t *d = dst;
+  while (size-- > 0)
+    *d++ = value;
+}
+
+/* Compares SIZE bytes at A and B one byte at a time, returning
+   nonzero if they differ. */
+static int
+byte_compare (const uint8_t *a, const uint8_t *b, size_t size)
+{
+  const volatile uint8_t *p = a;
+  for (; size-- > 0; p++, b++)
+    if (*p != *b)
+      return *p > *b ? +1 : -1;
+  return 0;
+}
+
+/* Returns the processor's time-stamp counter. */
+static inline uint64_t
+read_tsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
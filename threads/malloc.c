@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
+#include "threads/memtrack.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -32,7 +34,25 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   To keep most calls off the descriptor's lock, each descriptor
+   also has a small "magazine" of free blocks for the CPU, which
+   is only touched with interrupts disabled.  malloc() takes a
+   block from the magazine when it can, and otherwise refills it
+   with a batch of blocks from the free list under the lock.
+   free() puts blocks into the magazine, and when it is full,
+   moves a batch back to the free list.  As far as the arenas
+   are concerned, blocks in a magazine are still in use, so an
+   arena is freed only once all of its blocks have made it back
+   to the free list. */
+
+/* Number of blocks a magazine holds. */
+#define MAG_SIZE 16
+
+/* Number of blocks moved between a magazine and its free list
+   at a time. */
+#define MAG_BATCH (MAG_SIZE / 2)
 
 /* Descriptor. */
 struct desc
@@ -41,6 +61,10 @@ struct desc
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+
+    /* Protected by disabling interrupts. */
+    size_t mag_cnt;             /* Number of blocks in magazine. */
+    struct block *mag[MAG_SIZE]; /* Magazine of free blocks. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -66,6 +90,15 @@ static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct block *desc_get (struct desc *);
+static void desc_put (struct desc *, struct block *);
+static bool mag_push (struct desc *, struct block *);
+static struct block *mag_pop (struct desc *);
+static void *malloc_from (size_t, const void *caller);
+static size_t usable_size (void *);
+static size_t block_size (void *);
+static void *block_alloc (size_t);
+static void block_free (void *);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -81,13 +114,52 @@ malloc_init (void)
       d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
       list_init (&d->free_list);
       lock_init (&d->lock);
+      d->mag_cnt = 0;
     }
 }
 
+#ifdef MEMTRACK
+/* With MEMTRACK, every block handed out by malloc() starts with
+   one of these, recording whom to charge for it. */
+struct track_hdr
+  {
+    struct memtrack_site *site; /* Allocation site. */
+    size_t size;                /* Requested size. */
+  };
+#endif
+
 /* Obtains and returns a new block of at least SIZE bytes.
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) 
+{
+  return malloc_from (size, __builtin_return_address (0));
+}
+
+/* Allocates SIZE bytes on behalf of code at CALLER. */
+static void *
+malloc_from (size_t size, const void *caller UNUSED)
+{
+#ifdef MEMTRACK
+  struct track_hdr *h;
+
+  if (size > SIZE_MAX - sizeof *h)
+    return NULL;
+  h = block_alloc (size + sizeof *h);
+  if (h == NULL)
+    return NULL;
+  h->site = memtrack_alloc (caller, size);
+  h->size = size;
+  return h + 1;
+#else
+  return block_alloc (size);
+#endif
+}
+
+/* Does the work of malloc(): returns a new block of at least
+   SIZE bytes, or a null pointer if memory is not available. */
+static void *
+block_alloc (size_t size)
 {
   struct desc *d;
   struct block *b;
@@ -119,36 +191,29 @@ malloc (size_t size)
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
+  /* Fast path: take a block from the magazine. */
+  b = mag_pop (d);
+  if (b != NULL)
+    return b;
 
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
+  /* Get a block from the free list, and refill the magazine from
+     the free list too while we hold the lock. */
+  lock_acquire (&d->lock);
+  b = desc_get (d);
+  if (b != NULL)
     {
       size_t i;
 
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
+      for (i = 0; i < MAG_BATCH && !list_empty (&d->free_list); i++)
         {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
+          struct block *extra = desc_get (d);
+          if (!mag_push (d, extra))
+            {
+              desc_put (d, extra);
+              break;
+            }
         }
     }
-
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
   lock_release (&d->lock);
   return b;
 }
@@ -167,13 +232,27 @@ calloc (size_t a, size_t b)
     return NULL;
 
   /* Allocate and zero memory. */
-  p = malloc (size);
+  p = malloc_from (size, __builtin_return_address (0));
   if (p != NULL)
     memset (p, 0, size);
 
   return p;
 }
 
+/* Returns the number of bytes available to the caller in
+   BLOCK, which was returned by malloc(). */
+static size_t
+usable_size (void *block)
+{
+#ifdef MEMTRACK
+  struct track_hdr *h = (struct track_hdr *) block - 1;
+  ASSERT (h->size <= block_size (h) - sizeof *h);
+  return h->size;
+#else
+  return block_size (block);
+#endif
+}
+
 /* Returns the number of bytes allocated for BLOCK. */
 static size_t
 block_size (void *block) 
@@ -201,10 +280,11 @@ realloc (void *old_block, size_t new_size)
     }
   else 
     {
-      void *new_block = malloc (new_size);
+      void *new_block = malloc_from (new_size,
+                                     __builtin_return_address (0));
       if (old_block != NULL && new_block != NULL)
         {
-          size_t old_size = block_size (old_block);
+          size_t old_size = usable_size (old_block);
           size_t min_size = new_size < old_size ? new_size : old_size;
           memcpy (new_block, old_block, min_size);
           free (old_block);
@@ -217,6 +297,21 @@ realloc (void *old_block, size_t new_size)
    malloc(), calloc(), or realloc(). */
 void
 free (void *p) 
+{
+#ifdef MEMTRACK
+  if (p != NULL)
+    {
+      struct track_hdr *h = (struct track_hdr *) p - 1;
+      memtrack_free (h->site, h->size);
+      p = h;
+    }
+#endif
+  block_free (p);
+}
+
+/* Does the work of free(). */
+static void
+block_free (void *p)
 {
   if (p != NULL)
     {
@@ -232,26 +327,21 @@ free (void *p)
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
-  
-          lock_acquire (&d->lock);
 
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
+          /* Fast path: put the block in the magazine. */
+          if (mag_push (d, b))
+            return;
 
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
+          /* The magazine is full.  Return the block, and a batch
+             from the magazine, to the free list. */
+          lock_acquire (&d->lock);
+          desc_put (d, b);
+          while ((b = mag_pop (d)) != NULL)
             {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
+              desc_put (d, b);
+              if (d->mag_cnt <= MAG_SIZE - MAG_BATCH)
+                break;
             }
-
           lock_release (&d->lock);
         }
       else
@@ -292,3 +382,93 @@ arena_to_block (struct arena *a, size_t idx)
                            + sizeof *a
                            + idx * a->desc->block_size);
 }
+
+/* Takes a block from D's free list, creating a new arena if the
+   list is empty.  Returns a null pointer if memory is not
+   available.  D's lock must be held. */
+static struct block *
+desc_get (struct desc *d)
+{
+  struct block *b;
+  struct arena *a;
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  /* If the free list is empty, create a new arena. */
+  if (list_empty (&d->free_list))
+    {
+      size_t i;
+
+      /* Allocate a page. */
+      a = palloc_get_page (0);
+      if (a == NULL) 
+        return NULL; 
+
+      /* Initialize arena and add its blocks to the free list. */
+      a->magic = ARENA_MAGIC;
+      a->desc = d;
+      a->free_cnt = d->blocks_per_arena;
+      for (i = 0; i < d->blocks_per_arena; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_push_back (&d->free_list, &b->free_elem);
+        }
+    }
+
+  /* Get a block from free list and return it. */
+  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
+  a = block_to_arena (b);
+  a->free_cnt--;
+  return b;
+}
+
+/* Returns block B to D's free list, freeing its arena if that
+   leaves the arena entirely unused.  D's lock must be held. */
+static void
+desc_put (struct desc *d, struct block *b)
+{
+  struct arena *a = block_to_arena (b);
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  /* Add block to free list. */
+  list_push_front (&d->free_list, &b->free_elem);
+
+  /* If the arena is now entirely unused, free it. */
+  if (++a->free_cnt >= d->blocks_per_arena) 
+    {
+      size_t i;
+
+      ASSERT (a->free_cnt == d->blocks_per_arena);
+      for (i = 0; i < d->blocks_per_arena; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_remove (&b->free_elem);
+        }
+      palloc_free_page (a);
+    }
+}
+
+/* Adds B to D's magazine and returns true, or returns false if
+   the magazine is full. */
+static bool
+mag_push (struct desc *d, struct block *b)
+{
+  enum intr_level old_level = intr_disable ();
+  bool success = d->mag_cnt < MAG_SIZE;
+  if (success)
+    d->mag[d->mag_cnt++] = b;
+  intr_set_level (old_level);
+  return success;
+}
+
+/* Removes and returns a block from D's magazine, or returns a
+   null pointer if the magazine is empty. */
+static struct block *
+mag_pop (struct desc *d)
+{
+  enum intr_level old_level = intr_disable ();
+  struct block *b = d->mag_cnt > 0 ? d->mag[--d->mag_cnt] : NULL;
+  intr_set_level (old_level);
+  return b;
+}
@@ -0,0 +1,113 @@
+#include "threads/memtrack.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+
+/* An allocation site: a return address in a caller of malloc()
+   or palloc_get_*(), and what it has allocated. */
+struct memtrack_site
+  {
+    const void *caller;         /* Code address, or null if unused. */
+    size_t live_cnt;            /* Allocations not yet freed. */
+    size_t live_bytes;          /* Bytes in those allocations. */
+    size_t total_cnt;           /* Allocations ever made. */
+  };
+
+/* Number of sites tracked individually.  Allocations from any
+   further sites are lumped together in `other_site'. */
+#define SITE_CNT 512
+
+/* Number of sites printed by memtrack_print_stats(). */
+#define TOP_CNT 10
+
+/* Site table, an open-addressed hash table keyed on caller.
+   Protected by disabling interrupts, since the allocators call
+   into it with their own locks held. */
+static struct memtrack_site sites[SITE_CNT];
+static struct memtrack_site other_site;
+
+/* Returns the site for CALLER, adding it if necessary. */
+static struct memtrack_site *
+lookup_site (const void *caller)
+{
+  size_t i = ((uintptr_t) caller * 0x9e3779b1u) % SITE_CNT;
+  size_t probes;
+
+  for (probes = 0; probes < SITE_CNT; probes++)
+    {
+      struct memtrack_site *s = &sites[i];
+      if (s->caller == caller)
+        return s;
+      if (s->caller == NULL)
+        {
+          s->caller = caller;
+          return s;
+        }
+      i = (i + 1) % SITE_CNT;
+    }
+  return &other_site;
+}
+
+/* Charges an allocation of SIZE bytes to the site that CALLER
+   belongs to, and returns that site, which must later be passed
+   to memtrack_free() along with the same SIZE. */
+struct memtrack_site *
+memtrack_alloc (const void *caller, size_t size)
+{
+  enum intr_level old_level = intr_disable ();
+  struct memtrack_site *s = lookup_site (caller);
+  s->live_cnt++;
+  s->live_bytes += size;
+  s->total_cnt++;
+  intr_set_level (old_level);
+  return s;
+}
+
+/* Credits site S with freeing an allocation of SIZE bytes. */
+void
+memtrack_free (struct memtrack_site *s, size_t size)
+{
+  enum intr_level old_level = intr_disable ();
+  ASSERT (s->live_cnt > 0 && s->live_bytes >= size);
+  s->live_cnt--;
+  s->live_bytes -= size;
+  intr_set_level (old_level);
+}
+
+/* Prints the TOP_CNT allocation sites with the most live
+   bytes. */
+void
+memtrack_print_stats (void)
+{
+  static bool printed[SITE_CNT];
+  size_t i, rank;
+
+  /* Pages that malloc() carves into blocks are charged to
+     malloc() itself, so the same memory may appear twice. */
+  printf ("Allocation sites by live bytes:\n");
+  for (i = 0; i < SITE_CNT; i++)
+    printed[i] = false;
+
+  for (rank = 0; rank < TOP_CNT; rank++)
+    {
+      struct memtrack_site *top = NULL;
+
+      for (i = 0; i < SITE_CNT; i++)
+        if (!printed[i] && sites[i].live_cnt > 0
+            && (top == NULL || sites[i].live_bytes > top->live_bytes))
+          top = &sites[i];
+      if (top == NULL)
+        break;
+      printed[top - sites] = true;
+      printf ("  %p: %zu bytes in %zu live allocations (%zu total)\n",
+              top->caller, top->live_bytes, top->live_cnt,
+              top->total_cnt);
+    }
+  if (other_site.total_cnt > 0)
+    printf ("  other sites: %zu bytes in %zu live allocations "
+            "(%zu total)\n", other_site.live_bytes, other_site.live_cnt,
+            other_site.total_cnt);
+  printf ("The `backtrace' program can map these addresses to "
+          "source lines.\n");
+}
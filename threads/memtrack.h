@@ -0,0 +1,20 @@
+#ifndef THREADS_MEMTRACK_H
+#define THREADS_MEMTRACK_H
+
+#include <stddef.h>
+
+/* Kernel memory tracking.
+
+   When the kernel is built with MEMTRACK defined (e.g. with
+   "make MEMTRACK=1"), malloc() and the page allocator charge
+   every allocation to the code address it was made from, and
+   the allocation sites holding the most memory are printed at
+   shutdown. */
+
+struct memtrack_site;
+
+struct memtrack_site *memtrack_alloc (const void *caller, size_t size);
+void memtrack_free (struct memtrack_site *, size_t size);
+void memtrack_print_stats (void);
+
+#endif /* threads/memtrack.h */
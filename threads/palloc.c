@@ -1,13 +1,14 @@
 #include "threads/palloc.h"
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/loader.h"
+#include "threads/memtrack.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
@@ -25,20 +26,53 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
-/* A memory pool. */
+/* Number of buddy block orders: blocks of up to 2**20 pages. */
+#define ORDER_CNT 21
+
+/* A memory pool.
+
+   Each pool is managed as a binary buddy system.  Free memory is
+   kept as blocks of 2**ORDER pages, aligned (relative to the
+   pool's base) on a multiple of their own size, on one free list
+   per order.  A request for N pages takes the smallest free
+   block that can hold it, splitting larger blocks as needed, and
+   gives back the unused tail.  Freeing a block merges it with
+   its "buddy", the other half of the block of the next order up,
+   for as long as that buddy is free as well.  Both take time
+   logarithmic in the size of the pool.
+
+   The free lists are threaded through the free pages themselves.
+   A byte per page, kept at the start of the pool, records the
+   order of each free block at its first page. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages in pool. */
+    size_t free_cnt;                    /* Number of free pages. */
+    uint8_t *heads;                     /* Per-page free block info. */
+#ifdef MEMTRACK
+    struct memtrack_site **sites;       /* Per-page allocation site. */
+#endif
+    struct list free_lists[ORDER_CNT];  /* Free blocks, by order. */
   };
 
+/* In a pool's `heads', marks the first page of a free block,
+   whose order is in the remaining bits. */
+#define FREE_HEAD 0x80
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
+static void *get_pages (enum palloc_flags, size_t page_cnt,
+                        const void *caller);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t alloc_pages (struct pool *, size_t page_cnt);
+static void free_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static void free_block (struct pool *, size_t page_idx, int order);
+static void print_pool_stats (struct pool *, const char *name);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -70,34 +104,7 @@ palloc_init (size_t user_page_limit)
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
-  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-  void *pages;
-  size_t page_idx;
-
-  if (page_cnt == 0)
-    return NULL;
-
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
-
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
-  else
-    pages = NULL;
-
-  if (pages != NULL) 
-    {
-      if (flags & PAL_ZERO)
-        memset (pages, 0, PGSIZE * page_cnt);
-    }
-  else 
-    {
-      if (flags & PAL_ASSERT)
-        PANIC ("palloc_get: out of pages");
-    }
-
-  return pages;
+  return get_pages (flags, page_cnt, __builtin_return_address (0));
 }
 
 /* Obtains a single free page and returns its kernel virtual
@@ -110,7 +117,7 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 void *
 palloc_get_page (enum palloc_flags flags) 
 {
-  return palloc_get_multiple (flags, 1);
+  return get_pages (flags, 1, __builtin_return_address (0));
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -132,13 +139,22 @@ palloc_free_multiple (void *pages, size_t page_cnt)
     NOT_REACHED ();
 
   page_idx = pg_no (pages) - pg_no (pool->base);
+  ASSERT (page_idx + page_cnt <= pool->page_cnt);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  lock_acquire (&pool->lock);
+#ifdef MEMTRACK
+  {
+    size_t i;
+    for (i = 0; i < page_cnt; i++)
+      memtrack_free (pool->sites[page_idx + i], PGSIZE);
+  }
+#endif
+  free_pages (pool, page_idx, page_cnt);
+  lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +164,101 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of pages in the user pool. */
+size_t
+palloc_user_page_cnt (void)
+{
+  return user_pool.page_cnt;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void)
+{
+  print_pool_stats (&kernel_pool, "Kernel pool");
+  print_pool_stats (&user_pool, "User pool");
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  /* We'll put the pool's free block info, and with MEMTRACK
+     the allocation site of each page, at its base.  Calculate
+     the space needed for it and subtract it from the pool's
+     size. */
+  size_t info_size = page_cnt;
+  size_t info_pages;
+  int order;
+#ifdef MEMTRACK
+  info_size += (page_cnt + 1) * sizeof *p->sites;
+#endif
+  info_pages = DIV_ROUND_UP (info_size, PGSIZE);
+  if (info_pages > page_cnt)
+    PANIC ("Not enough memory in %s for free block info.", name);
+  page_cnt -= info_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
-  /* Initialize the pool. */
+  /* Initialize the pool, then free all of its pages. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->base = (uint8_t *) base + info_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  p->free_cnt = 0;
+  p->heads = base;
+  memset (p->heads, 0, page_cnt);
+#ifdef MEMTRACK
+  p->sites = (struct memtrack_site **) ROUND_UP ((uintptr_t) base + page_cnt,
+                                                 sizeof *p->sites);
+#endif
+  for (order = 0; order < ORDER_CNT; order++)
+    list_init (&p->free_lists[order]);
+  free_pages (p, 0, page_cnt);
+}
+
+/* Does the work of palloc_get_multiple(), on behalf of code at
+   CALLER. */
+static void *
+get_pages (enum palloc_flags flags, size_t page_cnt,
+           const void *caller UNUSED)
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  void *pages;
+  size_t page_idx;
+
+  if (page_cnt == 0)
+    return NULL;
+
+  lock_acquire (&pool->lock);
+  page_idx = alloc_pages (pool, page_cnt);
+#ifdef MEMTRACK
+  if (page_idx != SIZE_MAX)
+    {
+      size_t i;
+      for (i = 0; i < page_cnt; i++)
+        pool->sites[page_idx + i] = memtrack_alloc (caller, PGSIZE);
+    }
+#endif
+  lock_release (&pool->lock);
+
+  if (page_idx != SIZE_MAX)
+    pages = pool->base + PGSIZE * page_idx;
+  else
+    pages = NULL;
+
+  if (pages != NULL) 
+    {
+      if (flags & PAL_ZERO)
+        memset (pages, 0, PGSIZE * page_cnt);
+    }
+  else 
+    {
+      if (flags & PAL_ASSERT)
+        PANIC ("palloc_get: out of pages");
+    }
+
+  return pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +268,121 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the free list element stored in page PAGE_IDX of P. */
+static struct list_elem *
+page_elem (const struct pool *p, size_t page_idx)
+{
+  return (struct list_elem *) (p->base + PGSIZE * page_idx);
+}
+
+/* Returns the index of the page of P that holds free list
+   element E. */
+static size_t
+elem_page (const struct pool *p, struct list_elem *e)
+{
+  return ((uint8_t *) e - p->base) / PGSIZE;
+}
+
+/* Allocates PAGE_CNT contiguous pages from P and returns the
+   index of the first one, or SIZE_MAX if there is no free block
+   large enough.  P's lock must be held. */
+static size_t
+alloc_pages (struct pool *p, size_t page_cnt)
+{
+  size_t page_idx;
+  int order;
+
+  /* Find the smallest nonempty order that fits. */
+  for (order = 0; order < ORDER_CNT; order++)
+    if (((size_t) 1 << order) >= page_cnt
+        && !list_empty (&p->free_lists[order]))
+      break;
+  if (order >= ORDER_CNT)
+    return SIZE_MAX;
+
+  page_idx = elem_page (p, list_pop_front (&p->free_lists[order]));
+  p->heads[page_idx] = 0;
+  p->free_cnt -= (size_t) 1 << order;
+
+  /* Give back the part of the block we don't need. */
+  free_pages (p, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+  return page_idx;
+}
+
+/* Frees the PAGE_CNT pages of P starting at PAGE_IDX, which need
+   not form a single buddy block, by splitting them into the
+   largest properly aligned blocks.  P's lock must be held, or P
+   must not yet be in use. */
+static void
+free_pages (struct pool *p, size_t page_idx, size_t page_cnt)
+{
+  while (page_cnt > 0)
+    {
+      int order = 0;
+
+      while (order + 1 < ORDER_CNT
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      free_block (p, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Frees the block of 2**ORDER pages of P starting at PAGE_IDX,
+   merging it with its buddy as far as possible. */
+static void
+free_block (struct pool *p, size_t page_idx, int order)
+{
+  ASSERT ((p->heads[page_idx] & FREE_HEAD) == 0);
+
+  p->free_cnt += (size_t) 1 << order;
+  while (order + 1 < ORDER_CNT)
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+      if (buddy + ((size_t) 1 << order) > p->page_cnt
+          || p->heads[buddy] != (FREE_HEAD | order))
+        break;
+
+      list_remove (page_elem (p, buddy));
+      p->heads[buddy] = 0;
+      if (buddy < page_idx)
+        page_idx = buddy;
+      order++;
+    }
+
+  p->heads[page_idx] = FREE_HEAD | order;
+  list_push_front (&p->free_lists[order], page_elem (p, page_idx));
+}
+
+/* Prints statistics for pool P, called NAME: how much of it is
+   free, how many free blocks that is split across, and how
+   fragmented it is, as the percentage of free pages that lie
+   outside the largest free block. */
+static void
+print_pool_stats (struct pool *p, const char *name)
+{
+  size_t block_cnt = 0;
+  size_t largest = 0;
+  int order;
+
+  for (order = 0; order < ORDER_CNT; order++)
+    {
+      size_t cnt = list_size (&p->free_lists[order]);
+      block_cnt += cnt;
+      if (cnt > 0)
+        largest = (size_t) 1 << order;
+    }
+
+  printf ("%s: %zu of %zu pages free in %zu blocks, "
+          "largest %zu pages, %zu%% fragmented\n",
+          name, p->free_cnt, p->page_cnt, block_cnt, largest,
+          p->free_cnt > 0 ? 100 - largest * 100 / p->free_cnt : 0);
+}
@@ -1,6 +1,7 @@
 #ifndef THREADS_PTE_H
 #define THREADS_PTE_H
 
+#include <stddef.h>
 #include "threads/vaddr.h"
 
 /* Functions and macros for working with x86 hardware page
@@ -67,6 +68,12 @@ static inline uintptr_t pd_no (const void *va) {
 #define PTE_A 0x20              /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40              /* 1=dirty, 0=not dirty (PTEs only). */
 
+/* Software-defined flags, kept in the PTE_AVL bits. */
+#define PTE_COW 0x200           /* 1=copy-on-write: read-only until a
+                                   write gives it a private copy. */
+#define PTE_SWAP 0x400          /* 1=not present, swapped out to the
+                                   slot in the address bits. */
+
 /* Returns a PDE that points to page table PT. */
 static inline uint32_t pde_create (uint32_t *pt) {
   ASSERT (pg_ofs (pt) == 0);
@@ -103,5 +110,19 @@ static inline void *pte_get_page (uint32_t pte) {
   return ptov (pte & PTE_ADDR);
 }
 
+/* Returns a not-present PTE for a user page that has been
+   swapped out to swap slot SLOT.  If WRITABLE is true then the
+   page will be writable once it is brought back in. */
+static inline uint32_t pte_create_swap (size_t slot, bool writable) {
+  ASSERT (slot < (1u << (32 - PGBITS)));
+  return (slot << PGBITS) | PTE_SWAP | (writable ? PTE_W : 0);
+}
+
+/* Returns the swap slot that swapped-out PTE refers to. */
+static inline size_t pte_get_swap (uint32_t pte) {
+  ASSERT ((pte & (PTE_P | PTE_SWAP)) == PTE_SWAP);
+  return pte >> PGBITS;
+}
+
 #endif /* threads/pte.h */
 
@@ -0,0 +1,219 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Object caches.
+
+   malloc() rounds every request up to a power of 2, so a
+   structure that is a little larger than a power of 2 wastes
+   nearly half of its block.  An object cache instead serves
+   objects of a single type and size.  It carves pages, called
+   "slabs", into exactly as many objects as fit after a small
+   slab header, and keeps a free list of objects within each
+   slab.
+
+   Slabs that have some free objects are kept on the cache's
+   partial list, so that allocation normally just pops an object
+   off the first partial slab.  Slabs with no free objects sit on
+   the full list.  When a slab becomes entirely free, one such
+   slab is kept in reserve to absorb alloc/free cycles at the
+   boundary; any others go back to the page allocator.
+
+   If a cache has a constructor, it is run on every object when
+   its slab is created, and objects are expected to be returned
+   to kmem_cache_free() in their constructed state, so that the
+   constructor doesn't have to run again on reuse.  For such
+   caches, the free list link is stored after the object instead
+   of over its first bytes. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* A slab: a page holding a header followed by objects. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in a cache list. */
+    size_t free_cnt;            /* Number of free objects. */
+    void *free;                 /* First free object. */
+  };
+
+static struct slab *new_slab (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *obj);
+static void **obj_link (struct kmem_cache *, void *obj);
+
+/* Initializes cache C for objects of SIZE bytes, calling CTOR
+   (if non-null) to construct them.  NAME identifies the cache
+   in debugging output. */
+void
+kmem_cache_init (struct kmem_cache *c, const char *name, size_t size,
+                 kmem_ctor_func *ctor)
+{
+  ASSERT (size > 0);
+
+  c->name = name;
+  c->obj_size = size;
+  c->ctor = ctor;
+  if (ctor == NULL)
+    {
+      c->link_ofs = 0;
+      c->slot_size = ROUND_UP (size < sizeof (void *) ? sizeof (void *) : size,
+                               sizeof (void *));
+    }
+  else
+    {
+      c->link_ofs = ROUND_UP (size, sizeof (void *));
+      c->slot_size = c->link_ofs + sizeof (void *);
+    }
+  c->objs_per_slab = (PGSIZE - sizeof (struct slab)) / c->slot_size;
+  ASSERT (c->objs_per_slab > 0);
+
+  lock_init (&c->lock);
+  list_init (&c->partial);
+  list_init (&c->full);
+  c->empty = NULL;
+}
+
+/* Obtains and returns an object from cache C.  Returns a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&c->lock);
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else
+    {
+      if (c->empty != NULL)
+        {
+          s = c->empty;
+          c->empty = NULL;
+        }
+      else
+        {
+          s = new_slab (c);
+          if (s == NULL)
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  /* Take the first free object. */
+  obj = s->free;
+  s->free = *obj_link (c, obj);
+  if (--s->free_cnt == 0)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  lock_release (&c->lock);
+
+  return obj;
+}
+
+/* Returns OBJ, which must have been obtained from
+   kmem_cache_alloc() on cache C, to C. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj)
+{
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (c, obj);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     it is supposed to keep its constructed state. */
+  if (c->ctor == NULL)
+    memset (obj, 0xcc, c->obj_size);
+#endif
+
+  lock_acquire (&c->lock);
+  *obj_link (c, obj) = s->free;
+  s->free = obj;
+  if (s->free_cnt++ == 0)
+    {
+      /* It was full. */
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  if (s->free_cnt == c->objs_per_slab)
+    {
+      /* It is now empty.  Keep it as our spare, if we don't
+         already have one. */
+      list_remove (&s->elem);
+      if (c->empty == NULL)
+        c->empty = s;
+      else
+        palloc_free_page (s);
+    }
+  lock_release (&c->lock);
+}
+
+/* Allocates and returns a new slab for C, with all of its
+   objects free and constructed.  Returns a null pointer if
+   memory is not available. */
+static struct slab *
+new_slab (struct kmem_cache *c)
+{
+  struct slab *s;
+  uint8_t *obj;
+  size_t i;
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->free_cnt = c->objs_per_slab;
+  s->free = NULL;
+
+  /* Thread the objects onto the free list, last first, so that
+     they are handed out in address order. */
+  obj = (uint8_t *) (s + 1) + c->objs_per_slab * c->slot_size;
+  for (i = 0; i < c->objs_per_slab; i++)
+    {
+      obj -= c->slot_size;
+      if (c->ctor != NULL)
+        c->ctor (obj);
+      *obj_link (c, obj) = s->free;
+      s->free = obj;
+    }
+  return s;
+}
+
+/* Returns the slab that OBJ, an object of cache C, is in. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  /* Check that the slab is valid and belongs to C. */
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+
+  /* Check that the object is properly aligned for the slab. */
+  ASSERT ((pg_ofs (obj) - sizeof *s) % c->slot_size == 0);
+
+  return s;
+}
+
+/* Returns the free list link of OBJ, an object of cache C. */
+static void **
+obj_link (struct kmem_cache *c, void *obj)
+{
+  return (void **) ((uint8_t *) obj + c->link_ofs);
+}
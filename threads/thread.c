@@ -7,6 +7,7 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
@@ -23,9 +24,6 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* The maximum number of files opened a process can have */
-#define MAX_FILES 128 
-
 /* List of processes in THREAD_READY state, that is, processes
    that are ready to run but not actually running. */
 static struct list ready_list;
@@ -76,6 +74,7 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static void release_exit_records (void);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -205,37 +204,103 @@ thread_create (const char *name, int priority,
   sf->eip = switch_entry;
   sf->ebp = 0;
 
-  //add t to the calling thread's child list
-  list_push_front(&thread_current()->child_list, &t->child_elem);
-
   /* Add to run queue. */
   thread_unblock (t);
   
   return tid;
 }
 
-//Jasper driving now
+/* Returns a new exit record for a child of the running thread,
+   with one reference for the child and one for the running
+   thread, or a null pointer if memory is short.  The record is
+   already on the running thread's `children' list, under
+   TID_ERROR until the caller sets its tid, so that it is there
+   however soon the child runs.  The child must take it as its
+   `exit_record' before it can exit. */
+struct exit_record *
+exit_record_create (void)
+{
+  struct exit_record *rec = malloc (sizeof *rec);
+
+  if (rec != NULL)
+    {
+      rec->tid = TID_ERROR;
+      rec->exit_status = 0;
+      rec->loaded = false;
+      sema_init (&rec->load_sema, 0);
+      sema_init (&rec->exit_sema, 0);
+      rec->ref_cnt = 2;
+      list_push_front (&thread_current ()->children, &rec->elem);
+    }
+  return rec;
+}
 
-/* This method is to return the struct thread of the child
-  corresponding to tid from the calling thread's child list
-  or returns null if no child is found */
-struct thread* get_thread_from_tid(tid_t tid) 
+/* Returns the exit record of the running thread's child TID,
+   or a null pointer if TID is not a child that has yet to be
+   waited for.
+
+   This is a scan of the running thread's own children, not of
+   all threads.  The list only holds children that have not been
+   waited for, and the newest is first.  exec always looks up
+   the child it just created, and a shell usually waits for the
+   child it just started, so both find their record in one step.
+   A table keyed by tid would have to be allocated lazily for
+   every process and would gain nothing at these sizes. */
+struct exit_record *
+thread_child (tid_t tid)
 {
+  struct thread *cur = thread_current ();
   struct list_elem *e;
-  struct thread *cur = thread_current();
-  for (e = list_begin (&cur->child_list); e != list_end (&cur->child_list);
-           e = list_next (e))
-        {
-          struct thread *t = list_entry (e, struct thread, child_elem);
-          if(t->tid == tid) 
-          {
-            return t; //return child
-          }
-        }
-        return NULL;
+
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = list_next (e))
+    {
+      struct exit_record *rec = list_entry (e, struct exit_record, elem);
+      if (rec->tid == tid)
+        return rec;
+    }
+  return NULL;
 }
 
-//Jasper done driving
+/* Drops one reference to REC, freeing it when neither the child
+   nor its parent refers to it any longer.  The caller must
+   already have taken REC off its parent's list if it is the
+   parent. */
+void
+exit_record_release (struct exit_record *rec)
+{
+  enum intr_level old_level;
+  int ref_cnt;
+
+  old_level = intr_disable ();
+  ref_cnt = --rec->ref_cnt;
+  intr_set_level (old_level);
+
+  if (ref_cnt == 0)
+    free (rec);
+}
+
+/* Publishes the running thread's exit status to its parent and
+   lets go of its own exit record and those of its children. */
+static void
+release_exit_records (void)
+{
+  struct thread *cur = thread_current ();
+
+  if (cur->exit_record != NULL)
+    {
+      cur->exit_record->exit_status = cur->exit_status;
+      sema_up (&cur->exit_record->exit_sema);
+      exit_record_release (cur->exit_record);
+      cur->exit_record = NULL;
+    }
+
+  while (!list_empty (&cur->children))
+    {
+      struct list_elem *e = list_pop_front (&cur->children);
+      exit_record_release (list_entry (e, struct exit_record, elem));
+    }
+}
 
 /* Puts the current thread to sleep.  It will not be scheduled
    again until awoken by thread_unblock().
@@ -316,12 +381,16 @@ thread_exit (void)
 {
   ASSERT (!intr_context ());
 
+#ifdef USERPROG
+  process_flush_stdout ();
+#endif
   //print exit message for thread exiting
   printf("%s: exit(%d)\n", thread_current()->name, 
   thread_current()->exit_status);
 #ifdef USERPROG
   process_exit ();
 #endif
+  release_exit_records ();
 
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
@@ -483,19 +552,6 @@ is_thread (struct thread *t)
   return t != NULL && t->magic == THREAD_MAGIC;
 }
 
-/* A simple method for initializing the files in a new process
-to NULL. Simply takes in the set of files as a parameter. */
-void files_init(struct file *set_of_files[MAX_FILES]) 
-{
-  // A simple for loop that initializes file pointers to NULL
-  // at start.
-  unsigned i;
-  for(i = 0; i < MAX_FILES; i++)
-  {
-    set_of_files[i] = NULL;
-  }
-}
-
 /* Does basic initialization of T as a blocked thread named
    NAME. */
 static void
@@ -513,16 +569,12 @@ init_thread (struct thread *t, const char *name, int priority)
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
 
-  /* Where we initialize our semas for synchronization. */
-  sema_init(&t->child_wait, 0);
-  sema_init(&t->parent_wait, 0);
-  sema_init(&t->exec_sema, 0);
   t->magic = THREAD_MAGIC;
   t->exit_status = 0; // exit status set to default of 0.
-  // starts at 2 since 0 and 1 fds are reserved for console.
-  t->curr_file_index = 2;
-  files_init(t->set_of_files); // array of files initialized
-  list_init(&t->child_list);  // child list initialized.
+#ifdef USERPROG
+  fd_table_init (&t->fds);
+#endif
+  list_init (&t->children);
 
 
 
@@ -4,9 +4,14 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include <batch.h>
+#include <vmstat.h>
 #include "threads/synch.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
+#ifdef USERPROG
+#include "userprog/fdtable.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -26,7 +31,7 @@ typedef int tid_t;
 #define PRI_MIN 0                       /* Lowest priority. */
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
-#define MAX_FILES 128                   /* Max # of open files in process. */
+#define STDOUT_BUF_SIZE 128             /* Size of process's output buffer. */
 
 /* A kernel thread or user process.
 
@@ -80,6 +85,26 @@ typedef int tid_t;
    value, triggering the assertion.  (So don't add elements below 
    THREAD_MAGIC.)
 */
+/* What a thread leaves behind for its parent when it exits.
+
+   Only user processes have one.  The record is allocated apart
+   from the thread by process_execute() or process_fork() and
+   shared by the new process and its parent, so the process's
+   thread page, page directory, and files can all be freed as
+   soon as it exits, without waiting for its parent to call
+   wait.  Whichever of the two lets go of the record last frees
+   it. */
+struct exit_record
+  {
+    tid_t tid;                          /* Child's thread identifier. */
+    int exit_status;                    /* Set when the child exits. */
+    bool loaded;                        /* Did the child's program load? */
+    struct semaphore load_sema;         /* Upped once LOADED is set. */
+    struct semaphore exit_sema;         /* Upped once EXIT_STATUS is set. */
+    int ref_cnt;                        /* Parent and child, if alive. */
+    struct list_elem elem;              /* Parent's `children' list. */
+  };
+
 /* The `elem' member has a dual purpose.  It can be an element in
    the run queue (thread.c), or it can be an element in a
    semaphore wait list (synch.c).  It can be used these two ways
@@ -95,15 +120,9 @@ struct thread
     uint8_t *stack;                     /* Saved stack pointer. */
     int priority;                       /* Priority. */
     struct list_elem allelem;           /* List element for all threads list. */
-    struct list_elem child_elem;        /* List element for children list. */
-    struct list child_list;             /* List of children for thread. */
-    struct semaphore child_wait;        /* Used for waiting on child threads. */
-    struct semaphore parent_wait;       /* Used for waiting on parent thread. */
+    struct list children;               /* Exit records of children. */
+    struct exit_record *exit_record;    /* Our own, or null. */
     int exit_status;                    /* Status of thread before exit. */
-    struct semaphore exec_sema;        /* Used to wait on child's executable */
-    int childLoaded;                    /* Did child load or not */
-    struct file *set_of_files[MAX_FILES];  /* The set of files for process. */
-    int curr_file_index;                /* The current file descriptor */
     struct file* executable;            /* The executable file */
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
@@ -112,6 +131,11 @@ struct thread
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    struct vmstat vmstat;               /* Virtual memory statistics. */
+    struct fd_table fds;                /* Open files. */
+    struct batch_ring *batch_ring;      /* Batch ring, or null. */
+    size_t stdout_len;                  /* Bytes in stdout_buf. */
+    char stdout_buf[STDOUT_BUF_SIZE];   /* Pending console output. */
 #endif
 
     /* Owned by thread.c. */
@@ -132,14 +156,14 @@ void thread_print_stats (void);
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
-struct thread* get_thread_from_tid(tid_t tid);
+struct exit_record *exit_record_create (void);
+struct exit_record *thread_child (tid_t);
+void exit_record_release (struct exit_record *);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
 
 struct thread *thread_current (void);
-/* A helper method that gets corresponding thread with given tid */
-struct thread* get_thread_from_tid(tid_t tid);
 tid_t thread_tid (void);
 const char *thread_name (void);
 
@@ -2,9 +2,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/pagedir.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "userprog/syscall.h"
+#include "userprog/usermem.h"
+#include "vm/frame.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -12,6 +16,15 @@ static long long page_fault_cnt;
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 
+/* Returns the CPU's time stamp counter. */
+static inline uint64_t
+read_tsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
 /* Registers handlers for interrupts that can be caused by user
    programs.
 
@@ -127,6 +140,7 @@ page_fault (struct intr_frame *f)
   bool write;        /* True: access was write, false: access was read. */
   bool user;         /* True: access by user, false: access by kernel. */
   void *fault_addr;  /* Fault address. */
+  uint64_t start;    /* Time stamp counter at entry. */
 
   /* Obtain faulting address, the virtual address that was
      accessed to cause the fault.  It may point to code or to
@@ -136,6 +150,7 @@ page_fault (struct intr_frame *f)
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
   asm ("movl %%cr2, %0" : "=r" (fault_addr));
+  start = read_tsc ();
 
   /* Turn interrupts back on (they were only off so that we could
      be assured of reading CR2 before it changed). */
@@ -149,6 +164,35 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+  /* A write to a copy-on-write page, by the process itself or by
+     the kernel on its behalf (e.g. read() into a buffer): give
+     the process its own copy of the page and retry the access. */
+  if (!not_present && write && is_user_vaddr (fault_addr)
+      && thread_current ()->pagedir != NULL
+      && pagedir_unshare_page (thread_current ()->pagedir, fault_addr))
+    {
+      struct vmstat *vs = &thread_current ()->vmstat;
+      vs->minor_faults++;
+      vs->fault_cycles += read_tsc () - start;
+      return;
+    }
+
+  /* An access to a page that was evicted to swap, again by the
+     process or by the kernel on its behalf: read it back in and
+     retry. */
+  if (not_present && is_user_vaddr (fault_addr)
+      && thread_current ()->pagedir != NULL
+      && frame_page_in (thread_current ()->pagedir, fault_addr))
+    {
+      thread_current ()->vmstat.fault_cycles += read_tsc () - start;
+      return;
+    }
+
+  /* A bad user address passed to get_user() or put_user() by
+     the kernel: make the access fail instead. */
+  if (!user && usermem_fixup (f))
+    return;
+
   // Viren Drove here
   // Do valid pointer check on fault address so that we exit
   // with status of -1 when executing/reading/writing to an unmapped
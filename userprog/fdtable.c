@@ -0,0 +1,152 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+
+/* Bits in one word of the bitmap. */
+#define WORD_BITS 32
+
+/* Number of slots in a table's first allocation. */
+#define MIN_SLOTS WORD_BITS
+
+static bool grow (struct fd_table *);
+
+/* Initializes T as an empty table.  Memory is not allocated
+   until the first file is added. */
+void
+fd_table_init (struct fd_table *t)
+{
+  t->files = NULL;
+  t->used = NULL;
+  t->slot_cnt = 0;
+  t->hint = 0;
+}
+
+/* Makes DST, which must be empty, a copy of SRC, giving each of
+   SRC's files a new file on the same inode, under the same
+   descriptor and at the same position, that moves independently
+   from then on.  Returns false if memory was short, in which case
+   DST may hold only some of the files. */
+bool
+fd_table_dup (struct fd_table *dst, const struct fd_table *src)
+{
+  int slot;
+
+  ASSERT (dst->slot_cnt == 0);
+
+  while (dst->slot_cnt < src->slot_cnt)
+    if (!grow (dst))
+      return false;
+
+  for (slot = 0; slot < src->slot_cnt; slot++)
+    if (src->files[slot] != NULL)
+      {
+        struct file *file = file_reopen (src->files[slot]);
+        if (file == NULL)
+          return false;
+        file_seek (file, file_tell (src->files[slot]));
+        dst->files[slot] = file;
+        dst->used[slot / WORD_BITS] |= 1u << (slot % WORD_BITS);
+      }
+  dst->hint = src->hint;
+  return true;
+}
+
+/* Closes every file in T and frees T's memory. */
+void
+fd_table_destroy (struct fd_table *t)
+{
+  int slot;
+
+  for (slot = 0; slot < t->slot_cnt; slot++)
+    file_close (t->files[slot]);
+  free (t->files);
+  fd_table_init (t);
+}
+
+/* Adds FILE to T under the lowest free descriptor, which is
+   returned.  Returns -1 if memory is not available. */
+int
+fd_table_add (struct fd_table *t, struct file *file)
+{
+  int word_cnt, slot;
+
+  ASSERT (file != NULL);
+
+  /* Every word before the hint is full, so the first word with a
+     free slot is usually the hint itself. */
+  word_cnt = t->slot_cnt / WORD_BITS;
+  while (t->hint < word_cnt && t->used[t->hint] == UINT32_MAX)
+    t->hint++;
+  if (t->hint == word_cnt && !grow (t))
+    return -1;
+
+  slot = t->hint * WORD_BITS + __builtin_ctz (~t->used[t->hint]);
+  t->used[t->hint] |= 1u << (slot % WORD_BITS);
+  t->files[slot] = file;
+  return slot + FD_FIRST;
+}
+
+/* Returns the file in T with descriptor FD, or a null pointer if
+   FD is not open. */
+struct file *
+fd_table_get (const struct fd_table *t, int fd)
+{
+  int slot = fd - FD_FIRST;
+
+  return slot >= 0 && slot < t->slot_cnt ? t->files[slot] : NULL;
+}
+
+/* Removes the file with descriptor FD from T, freeing FD for
+   reuse, and returns the file, which the caller must close.
+   Returns a null pointer if FD is not open. */
+struct file *
+fd_table_remove (struct fd_table *t, int fd)
+{
+  struct file *file = fd_table_get (t, fd);
+
+  if (file != NULL)
+    {
+      int slot = fd - FD_FIRST;
+      int word = slot / WORD_BITS;
+
+      t->files[slot] = NULL;
+      t->used[word] &= ~(1u << (slot % WORD_BITS));
+      if (word < t->hint)
+        t->hint = word;
+    }
+  return file;
+}
+
+/* Doubles the number of slots in T.  The file pointers and the
+   bitmap share one allocation.  Returns false, leaving T
+   unchanged, if memory is not available. */
+static bool
+grow (struct fd_table *t)
+{
+  int new_cnt = t->slot_cnt > 0 ? t->slot_cnt * 2 : MIN_SLOTS;
+  int old_words = t->slot_cnt / WORD_BITS;
+  int new_words = new_cnt / WORD_BITS;
+  struct file **files;
+  uint32_t *used;
+
+  files = malloc (new_cnt * sizeof *files + new_words * sizeof *used);
+  if (files == NULL)
+    return false;
+  used = (uint32_t *) (files + new_cnt);
+
+  if (t->slot_cnt > 0)
+    {
+      memcpy (files, t->files, t->slot_cnt * sizeof *files);
+      memcpy (used, t->used, old_words * sizeof *used);
+    }
+  memset (files + t->slot_cnt, 0, (new_cnt - t->slot_cnt) * sizeof *files);
+  memset (used + old_words, 0, (new_words - old_words) * sizeof *used);
+  free (t->files);
+
+  t->files = files;
+  t->used = used;
+  t->slot_cnt = new_cnt;
+  return true;
+}
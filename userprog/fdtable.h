@@ -0,0 +1,39 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct file;
+
+/* File descriptor table.
+
+   Maps a process's file descriptors to its open files.  The
+   table is allocated apart from the thread, starts out empty,
+   and doubles in size as needed, so the number of files a
+   process can have open is limited only by kernel memory.
+
+   Descriptors 0 and 1 are the console, so files get
+   descriptors from FD_FIRST up.  Opening a file always gets the
+   lowest free descriptor, found with a bitmap of slots in use,
+   so descriptors of closed files are reused. */
+struct fd_table
+  {
+    struct file **files;        /* Open file in each slot, or null. */
+    uint32_t *used;             /* Bitmap of slots in use. */
+    int slot_cnt;               /* Number of slots, a multiple of 32. */
+    int hint;                   /* Words of USED before this are full. */
+  };
+
+/* Lowest file descriptor for a file. */
+#define FD_FIRST 2
+
+void fd_table_init (struct fd_table *);
+bool fd_table_dup (struct fd_table *dst, const struct fd_table *src);
+void fd_table_destroy (struct fd_table *);
+
+int fd_table_add (struct fd_table *, struct file *);
+struct file *fd_table_get (const struct fd_table *, int fd);
+struct file *fd_table_remove (struct fd_table *, int fd);
+
+#endif /* userprog/fdtable.h */
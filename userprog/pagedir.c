@@ -5,9 +5,13 @@
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
 
 static uint32_t *active_pd (void);
 static void invalidate_pagedir (uint32_t *);
+static void *pt_upage (uint32_t *pd, uint32_t *pde, uint32_t *pt,
+                       uint32_t *pte);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -22,8 +26,8 @@ pagedir_create (void)
   return pd;
 }
 
-/* Destroys page directory PD, freeing all the pages it
-   references. */
+/* Destroys page directory PD, releasing all the frames and swap
+   slots it references. */
 void
 pagedir_destroy (uint32_t *pd) 
 {
@@ -40,13 +44,67 @@ pagedir_destroy (uint32_t *pd)
         uint32_t *pte;
         
         for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
-          if (*pte & PTE_P) 
-            palloc_free_page (pte_get_page (*pte));
+          if (*pte & (PTE_P | PTE_SWAP)) 
+            frame_unmap (pd, pt_upage (pd, pde, pt, pte));
         palloc_free_page (pt);
       }
   palloc_free_page (pd);
 }
 
+/* Creates and returns a new page directory with the same user
+   mappings as PD, for a forked process.  Rather than copying
+   any pages, every frame is shared between the two, with
+   writable pages turned into read-only copy-on-write pages in
+   both; the first write to such a page by either process gives
+   it a private copy (see pagedir_unshare_page()).  Pages of PD
+   that are swapped out are read back in first.
+   Returns a null pointer if memory allocation fails. */
+uint32_t *
+pagedir_clone (uint32_t *pd)
+{
+  uint32_t *copy;
+  uint32_t *pde;
+
+  copy = pagedir_create ();
+  if (copy == NULL)
+    return NULL;
+
+  for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
+    if (*pde & PTE_P) 
+      {
+        uint32_t *pt = pde_get_pt (*pde);
+        uint32_t *copy_pt;
+        size_t i;
+
+        copy_pt = palloc_get_page (PAL_ZERO);
+        if (copy_pt == NULL)
+          {
+            invalidate_pagedir (pd);
+            pagedir_destroy (copy);
+            return NULL;
+          }
+        copy[pde - pd] = pde_create (copy_pt);
+
+        for (i = 0; i < PGSIZE / sizeof *pt; i++)
+          if (pt[i] & (PTE_P | PTE_SWAP))
+            {
+              if (!frame_share (pd, pt_upage (pd, pde, pt, &pt[i])))
+                {
+                  invalidate_pagedir (pd);
+                  pagedir_destroy (copy);
+                  return NULL;
+                }
+              if (pt[i] & (PTE_W | PTE_COW))
+                pt[i] = (pt[i] & ~(uint32_t) PTE_W) | PTE_COW;
+              copy_pt[i] = pt[i];
+            }
+      }
+
+  /* PD may have cached writable translations. */
+  invalidate_pagedir (pd);
+  return copy;
+}
+
 /* Returns the address of the page table entry for virtual
    address VADDR in page directory PD.
    If PD does not have a page table for VADDR, behavior depends
@@ -118,6 +176,23 @@ pagedir_set_page (uint32_t *pd, void *upage, void *kpage, bool writable)
     return false;
 }
 
+/* Like pagedir_set_page(), but maps UPAGE to KPAGE read-only and
+   copy-on-write, so that the first write to UPAGE gives PD a
+   private, writable copy of KPAGE's contents.
+   Returns true if successful, false if memory allocation
+   failed. */
+bool
+pagedir_set_page_cow (uint32_t *pd, void *upage, void *kpage)
+{
+  uint32_t *pte;
+
+  if (!pagedir_set_page (pd, upage, kpage, false))
+    return false;
+  pte = lookup_page (pd, upage, false);
+  *pte |= PTE_COW;
+  return true;
+}
+
 /* Looks up the physical address that corresponds to user virtual
    address UADDR in PD.  Returns the kernel virtual address
    corresponding to that physical address, or a null pointer if
@@ -136,6 +211,50 @@ pagedir_get_page (uint32_t *pd, const void *uaddr)
     return NULL;
 }
 
+/* Returns true if user virtual address UADDR is mapped in PD,
+   whether its page is resident or swapped out. */
+bool
+pagedir_is_mapped (uint32_t *pd, const void *uaddr)
+{
+  uint32_t *pte;
+
+  ASSERT (is_user_vaddr (uaddr));
+
+  pte = lookup_page (pd, uaddr, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_SWAP)) != 0;
+}
+
+/* Replaces the mapping of user virtual page UPAGE in PD, which
+   must be resident, by a "not present" entry recording that its
+   contents are in swap slot SLOT.  Writability is preserved. */
+void
+pagedir_set_swap (uint32_t *pd, const void *upage, size_t slot)
+{
+  uint32_t *pte;
+
+  ASSERT (pg_ofs (upage) == 0);
+
+  pte = lookup_page (pd, upage, false);
+  ASSERT (pte != NULL && (*pte & PTE_P) != 0);
+  *pte = pte_create_swap (slot, (*pte & PTE_W) != 0);
+  invalidate_pagedir (pd);
+}
+
+/* If user virtual page UPAGE in PD is swapped out, returns its
+   swap slot and stores in *WRITABLE whether the page is
+   writable.  Otherwise, returns SWAP_ERROR. */
+size_t
+pagedir_get_swap (uint32_t *pd, const void *upage, bool *writable)
+{
+  uint32_t *pte;
+
+  pte = lookup_page (pd, upage, false);
+  if (pte == NULL || (*pte & (PTE_P | PTE_SWAP)) != PTE_SWAP)
+    return SWAP_ERROR;
+  *writable = (*pte & PTE_W) != 0;
+  return pte_get_swap (*pte);
+}
+
 /* Marks user virtual page UPAGE "not present" in page
    directory PD.  Later accesses to the page will fault.  Other
    bits in the page table entry are preserved.
@@ -156,6 +275,30 @@ pagedir_clear_page (uint32_t *pd, void *upage)
     }
 }
 
+/* Handles a write to the copy-on-write page that contains user
+   virtual address UADDR in PD by remapping it, writable, to a
+   frame that PD alone refers to.  Returns true if successful,
+   false if UADDR is not in a copy-on-write page or memory
+   allocation fails. */
+bool
+pagedir_unshare_page (uint32_t *pd, const void *uaddr)
+{
+  uint32_t *pte;
+  void *kpage;
+
+  pte = lookup_page (pd, uaddr, false);
+  if (pte == NULL || (*pte & (PTE_P | PTE_COW)) != (PTE_P | PTE_COW))
+    return false;
+
+  kpage = frame_unshare (pte_get_page (*pte));
+  if (kpage == NULL)
+    return false;
+  *pte = pte_create_user (kpage, true);
+  invalidate_pagedir (pd);
+  frame_map (kpage, pd, pg_round_down (uaddr));
+  return true;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -261,3 +404,12 @@ invalidate_pagedir (uint32_t *pd)
       pagedir_activate (pd);
     } 
 }
+
+/* Returns the user virtual address mapped by PTE, an entry in
+   page table PT, which is referenced by PDE in PD. */
+static void *
+pt_upage (uint32_t *pd, uint32_t *pde, uint32_t *pt, uint32_t *pte)
+{
+  return (void *) (((uintptr_t) (pde - pd) << PDSHIFT)
+                   | ((uintptr_t) (pte - pt) << PTSHIFT));
+}
@@ -2,13 +2,20 @@
 #define USERPROG_PAGEDIR_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 uint32_t *pagedir_create (void);
 void pagedir_destroy (uint32_t *pd);
+uint32_t *pagedir_clone (uint32_t *pd);
 bool pagedir_set_page (uint32_t *pd, void *upage, void *kpage, bool rw);
+bool pagedir_set_page_cow (uint32_t *pd, void *upage, void *kpage);
+bool pagedir_is_mapped (uint32_t *pd, const void *uaddr);
+void pagedir_set_swap (uint32_t *pd, const void *upage, size_t slot);
+size_t pagedir_get_swap (uint32_t *pd, const void *upage, bool *writable);
 void *pagedir_get_page (uint32_t *pd, const void *upage);
 void pagedir_clear_page (uint32_t *pd, void *upage);
+bool pagedir_unshare_page (uint32_t *pd, const void *uaddr);
 bool pagedir_is_dirty (uint32_t *pd, const void *upage);
 void pagedir_set_dirty (uint32_t *pd, const void *upage, bool dirty);
 bool pagedir_is_accessed (uint32_t *pd, const void *upage);
@@ -11,20 +11,35 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/syscall.h"
 #include "threads/synch.h"
+#include "vm/frame.h"
  
+/* If true, print virtual memory statistics at process exit. */
+bool process_print_vmstat;
+
 static thread_func start_process NO_RETURN;
+static thread_func start_fork NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 
 #define STACK_SIZE 4096  // The size of stack.
 
+/* Passed from process_execute() to the new process, in a page
+   of its own. */
+struct exec_info
+  {
+    struct exit_record *exit_record;    /* Shared with the parent. */
+    char cmd_line[];                    /* To the end of the page. */
+  };
+
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
    before process_execute() returns.  Returns the new process's
@@ -32,7 +47,8 @@ static bool load (const char *cmdline, void (**eip) (void), void **esp);
 tid_t
 process_execute (const char *file_name) 
 {
-  char *fn_copy;
+  struct exec_info *info;
+  struct exit_record *rec;
   char *fn_temp;
   char *fn;
   char *save_ptr;
@@ -40,10 +56,16 @@ process_execute (const char *file_name)
  
   /* Make a copy of FILE_NAME.
      Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (PAL_ZERO);
-  if (fn_copy == NULL)
+  info = palloc_get_page (PAL_ZERO);
+  if (info == NULL)
     return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
+  strlcpy (info->cmd_line, file_name, PGSIZE - sizeof *info);
+  rec = info->exit_record = exit_record_create ();
+  if (rec == NULL)
+    {
+      palloc_free_page (info);
+      return TID_ERROR;
+    }
 
   //Jordan driving now
   
@@ -52,19 +74,30 @@ process_execute (const char *file_name)
   //into thread_create
   fn_temp = palloc_get_page (PAL_ZERO);
   if(fn_temp == NULL)
-    return TID_ERROR;
-  strlcpy(fn_temp, file_name, PGSIZE);
-  fn = strtok_r(fn_temp, " ", &save_ptr);
+    tid = TID_ERROR;
+  else
+  {
+    strlcpy(fn_temp, file_name, PGSIZE);
+    fn = strtok_r(fn_temp, " ", &save_ptr);
  
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (fn, PRI_DEFAULT, start_process, fn_copy);
+    /* Create a new thread to execute FILE_NAME.  It frees
+       INFO, possibly before thread_create() returns, so only
+       REC may be used from here on. */
+    tid = thread_create (fn, PRI_DEFAULT, start_process, info);
   
-  palloc_free_page(fn_temp);
+    palloc_free_page(fn_temp);
+  }
 
   //Jordan done driving
 
   if (tid == TID_ERROR)
-    palloc_free_page (fn_copy);
+    {
+      list_remove (&rec->elem);
+      free (rec);
+      palloc_free_page (info);
+    }
+  else
+    rec->tid = tid;
 
   return tid;
 }
@@ -72,35 +105,35 @@ process_execute (const char *file_name)
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *info_)
 {
-  char *file_name = file_name_;
+  struct exec_info *info = info_;
   struct intr_frame if_;
   bool success;
+
+  thread_current ()->exit_record = info->exit_record;
  
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
+  success = load (info->cmd_line, &if_.eip, &if_.esp);
  
   /* If load failed, quit. */
-  palloc_free_page (file_name);
+  palloc_free_page (info);
 
   //Viren driving now
 
-  //upon unsuccessful load, unblock child and exit
+  //tell the parent waiting in exec whether we loaded
+  thread_current()->exit_record->loaded = success;
+  sema_up(&thread_current()->exit_record->load_sema);
+
+  //upon unsuccessful load, exit
   if (!success) 
   {
-    sema_up(&thread_current()->exec_sema);
-    process_exit ();
-  }
-  //if successful set the childLoaded flag and unblock child
-  else 
-  {
-    thread_current()->childLoaded = 1;
-    sema_up(&thread_current()->exec_sema);
+    thread_current()->exit_status = -1;
+    thread_exit ();
   }
 
   //Viren done driving
@@ -115,47 +148,206 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
  
+/* Passed from process_fork() to the child it creates. */
+struct fork_info
+  {
+    struct thread *parent;      /* Forking process. */
+    struct exit_record *exit_record; /* Shared with the parent. */
+    struct intr_frame if_;      /* Parent's user context at the fork. */
+    struct semaphore done;      /* Upped when the child is set up. */
+    bool success;               /* Did the child set up successfully? */
+  };
+
+/* Starts a new process that is a duplicate of the current one,
+   resuming in user mode from interrupt frame F, the current
+   process's system call frame.  The child's address space
+   shares every frame with the parent copy-on-write, so nothing
+   is copied or reloaded from the executable up front.  Returns
+   the child's thread id to the parent, or TID_ERROR if the child
+   could not be created; the child sees a return value of 0. */
+tid_t
+process_fork (struct intr_frame *f)
+{
+  struct fork_info info;
+  tid_t tid;
+
+  info.parent = thread_current ();
+  info.exit_record = exit_record_create ();
+  info.if_ = *f;
+  sema_init (&info.done, 0);
+  info.success = false;
+  if (info.exit_record == NULL)
+    return TID_ERROR;
+
+  tid = thread_create (thread_name (), PRI_DEFAULT, start_fork, &info);
+  if (tid == TID_ERROR)
+    {
+      list_remove (&info.exit_record->elem);
+      free (info.exit_record);
+      return TID_ERROR;
+    }
+
+  /* INFO lives on our stack, so wait until the child is done
+     with it.  A child that failed to set up exits on its own,
+     and its pid is never handed out, so drop our reference to
+     its record. */
+  sema_down (&info.done);
+  if (!info.success)
+    {
+      list_remove (&info.exit_record->elem);
+      exit_record_release (info.exit_record);
+      return TID_ERROR;
+    }
+  info.exit_record->tid = tid;
+  return tid;
+}
+
+/* A thread function that turns a new thread into a copy of the
+   process that forked it, then starts it running in user mode. */
+static void
+start_fork (void *info_)
+{
+  struct fork_info *info = info_;
+  struct thread *cur = thread_current ();
+  struct thread *parent = info->parent;
+  struct intr_frame if_ = info->if_;
+  bool success = false;
+
+  cur->exit_record = info->exit_record;
+  cur->pagedir = pagedir_clone (parent->pagedir);
+  if (cur->pagedir != NULL)
+    {
+      process_activate ();
+
+      /* Keep our own executable open with writes denied. */
+      cur->executable = file_reopen (parent->executable);
+      if (cur->executable != NULL)
+        {
+          file_deny_write (cur->executable);
+          success = true;
+        }
+
+      /* Duplicate open files.  Each copy starts at the parent's
+         current position but moves independently from then on. */
+      if (!fd_table_dup (&cur->fds, &parent->fds))
+        success = false;
+
+      /* The batch ring, if any, is at the same address in our
+         copy of the address space. */
+      cur->batch_ring = parent->batch_ring;
+    }
+
+  info->success = success;
+  sema_up (&info->done);
+  if (!success)
+    {
+      cur->exit_status = -1;
+      thread_exit ();
+    }
+
+  /* Return 0 from the system call in the child. */
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+ 
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
    immediately, without waiting.
- 
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+
+   The child's exit record outlives the child, so this works
+   the same whether or not the child has already exited. */
 int
-process_wait (tid_t child_tid UNUSED) 
+process_wait (tid_t child_tid) 
 {
   //Brock driving now
 
-  struct thread *parent = thread_current();
-  struct thread *child;
-
-  child = get_thread_from_tid(child_tid);
+  struct exit_record *rec = thread_child(child_tid);
+  int status;
 
-  if(child == NULL) 
+  if(rec == NULL) 
     return -1;
 
-  else 
-  {
-    //block parent until child exits
-    sema_down(&child->parent_wait);
-
-    //get child's exit status after unblocks
-    int status = child->exit_status;
- 
-    //remove child from child list and unblock child waiting on
-    //this thread(parent) to call wait
-    list_remove(&child->child_elem);
-    sema_up(&child->child_wait);
- 
-    return status;
-  }
+  //block parent until child exits, then take the record off
+  //our list so TID can't be waited for again
+  sema_down(&rec->exit_sema);
+  status = rec->exit_status;
+  list_remove(&rec->elem);
+  exit_record_release(rec);
+  return status;
 
   //Brock done driving
 }
  
+/* Writes the SIZE bytes in BUFFER, which is in user memory, to
+   the console on behalf of the current process.
+
+   Console output is line buffered.  Complete lines are written
+   out right away, together with any earlier partial line.  A
+   trailing partial line is held back until the process writes
+   the rest of it, makes another system call, or exits; see
+   process_flush_stdout().
+
+   BUFFER is always copied into the process's stdout buffer,
+   and only that is passed to putbuf(), a buffer's worth at a
+   time if need be.  The console layers read their input with
+   interrupts off, so they must never be handed user memory,
+   which could fault and have to be paged in from swap. */
+void
+process_write_stdout (const char *buffer, size_t size)
+{
+  struct thread *cur = thread_current ();
+  size_t line_len;
+
+  /* Find the end of the last complete line in BUFFER. */
+  for (line_len = size; line_len > 0; line_len--)
+    if (buffer[line_len - 1] == '\n')
+      break;
+
+  while (size > 0)
+    {
+      /* Copy as much as fits, but not past the last newline. */
+      size_t chunk = STDOUT_BUF_SIZE - cur->stdout_len;
+      if (line_len > 0 && line_len < chunk)
+        chunk = line_len;
+      if (size < chunk)
+        chunk = size;
+
+      memcpy (cur->stdout_buf + cur->stdout_len, buffer, chunk);
+      cur->stdout_len += chunk;
+      buffer += chunk;
+      size -= chunk;
+
+      /* Write it out if the buffer is full or the last complete
+         line is in. */
+      if (line_len > 0)
+        {
+          line_len -= chunk;
+          if (line_len == 0)
+            process_flush_stdout ();
+        }
+      if (cur->stdout_len == STDOUT_BUF_SIZE)
+        process_flush_stdout ();
+    }
+}
+
+/* Writes out any console output that the current process has
+   buffered. */
+void
+process_flush_stdout (void)
+{
+  struct thread *cur = thread_current ();
+
+  if (cur->stdout_len > 0)
+    {
+      putbuf (cur->stdout_buf, cur->stdout_len);
+      cur->stdout_len = 0;
+    }
+}
+
 /* Free the current process's resources. */
 void
 process_exit (void)
@@ -164,33 +356,23 @@ process_exit (void)
 
   struct thread *cur = thread_current ();
   uint32_t *pd;
- 
-  struct list_elem *e;
-  struct thread *child;
-  int i;
 
-  // Goes through all files opened and closes them.
-  // Since just closing all files opened in process,
-  // only go up to the current file index and don't
-  // have to waste time going through the max number
-  // of files (128) when we don't have to.
-  for(i = 0; i < cur->curr_file_index; i++) 
-  {
-    file_close(cur->set_of_files[i]);
-  }
-  //unblock parent waiting for this thread(child) to call exit
-  sema_up(&cur->parent_wait);
-  //block child until parent calls wait or exit
-  sema_down(&cur->child_wait);
-  //loop through children and unblock them if waiting on this thread
-  //(parent) to call wait or exit
-  for (e = list_begin (&cur->child_list); e != list_end (&cur->child_list);
-        e = list_next (e))
+  if (process_print_vmstat && cur->pagedir != NULL)
     {
-      child = list_entry (e, struct thread, child_elem);
-      sema_up(&child->child_wait);  
+      struct vmstat *vs = &cur->vmstat;
+      printf ("%s: vmstat: %u minor faults, %u major faults, "
+              "%u evictions, %u swap-ins, %u swap-outs, "
+              "%"PRIu64" fault cycles\n",
+              cur->name, vs->minor_faults, vs->major_faults,
+              vs->evictions, vs->swap_ins, vs->swap_outs,
+              vs->fault_cycles);
     }
-  
+
+  // Closes all files opened by the process.  Our exit status
+  // goes to our parent through our exit record once we are
+  // done here; see thread_exit().
+  fd_table_destroy(&cur->fds);
+
   //Jasper done driving
   
   /* Destroy the current process's page directory and switch back
@@ -209,6 +391,12 @@ process_exit (void)
       pagedir_activate (NULL);
       pagedir_destroy (pd);
     }
+
+  /* Close the executable (allowing writes to it again) only
+     after our mappings of its pages are gone, so that a shared
+     code page can never outlive the file contents it caches. */
+  file_close (cur->executable);
+  cur->executable = NULL;
 }
  
 /* Sets up the CPU for running user code in the current
@@ -294,6 +482,57 @@ static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
+
+/* A loadable segment of an executable, in the form that
+   load_segment() takes. */
+struct segment
+  {
+    off_t file_page;            /* Page-aligned offset in the file. */
+    uint32_t mem_page;          /* Page-aligned user virtual address. */
+    uint32_t read_bytes;        /* Bytes to read from the file. */
+    uint32_t zero_bytes;        /* Bytes to zero after those. */
+    bool writable;              /* Map writable? */
+  };
+
+/* The result of reading and checking an executable's ELF header
+   and program headers, which is all load() needs from them. */
+struct image
+  {
+    struct list_elem elem;      /* Element in image_cache. */
+    struct inode *inode;        /* Executable, held open by the cache. */
+    unsigned write_cnt;         /* inode_write_cnt() when parsed. */
+    int ref_cnt;                /* Cache's reference plus loads in use. */
+    void (*entry) (void);       /* Entry point. */
+    int segment_cnt;            /* Number of elements in SEGMENTS. */
+    struct segment segments[];  /* Loadable segments, in file order. */
+  };
+
+/* Image cache.
+
+   Parsed executables are kept by inode, most recently used
+   first, so that a shell running the same few programs over and
+   over only reads and checks their headers once.  An image goes
+   stale as soon as its executable is written, which the cache
+   detects by comparing inode write counts.  Each image keeps its
+   inode open so that the inode, and so its write count, cannot
+   go away and be replaced by another; a removed executable's
+   blocks are therefore only freed once its image drops off the
+   end of the cache. */
+#define IMAGE_CACHE_MAX 16
+static struct list image_cache;
+static int image_cnt;
+static struct lock image_lock;
+
+static struct image *image_get (struct file *, const char *file_name);
+static void image_release (struct image *);
+
+/* Initializes the image cache. */
+void
+process_init (void)
+{
+  list_init (&image_cache);
+  lock_init (&image_lock);
+}
  
 /* Loads an ELF executable from FILE_NAME into the current thread.
    Stores the executable's entry point into *EIP
@@ -303,9 +542,8 @@ bool
 load (const char *file_name, void (**eip) (void), void **esp) 
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
+  struct image *image = NULL;
   struct file *file = NULL;
-  off_t file_ofs;
   bool success = false;
   int i;
 
@@ -350,8 +588,81 @@ load (const char *file_name, void (**eip) (void), void **esp)
   //set and deny writes to this executable file
   t->executable = file;
   file_deny_write(file);
+  /* Map the executable's loadable segments. */
+  image = image_get (file, file_name);
+  if (image == NULL)
+    goto done;
+  for (i = 0; i < image->segment_cnt; i++)
+    {
+      const struct segment *seg = &image->segments[i];
+      if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+                         seg->read_bytes, seg->zero_bytes, seg->writable))
+        goto done;
+    }
+ 
+  /* Set up stack. */
+  if (!setup_stack (esp, file_name))
+    goto done;
+ 
+  /* Start address. */
+  *eip = image->entry;
+ 
+  success = true;
+ 
+ done:
+  if (image != NULL)
+    image_release (image);
+  palloc_free_page(filename);
+  palloc_free_page(actualFileName);
+  return success;
+
+  //Brock done driving
+}
+/* load() helpers. */
+ 
+/* Returns the parsed image of executable FILE, named FILE_NAME,
+   from the image cache, reading and checking FILE's headers and
+   adding the result to the cache if necessary.  Returns a null
+   pointer if FILE is not a valid executable or memory is short.
+   The caller must release the image with image_release(). */
+static struct image *
+image_get (struct file *file, const char *file_name)
+{
+  struct inode *inode = file_get_inode (file);
+  struct Elf32_Ehdr ehdr;
+  struct image *image;
+  struct list_elem *e;
+  off_t file_ofs;
+  int i;
+
+  lock_acquire (&image_lock);
+  for (e = list_begin (&image_cache); e != list_end (&image_cache);
+       e = list_next (e))
+    {
+      image = list_entry (e, struct image, elem);
+      if (image->inode == inode)
+        {
+          list_remove (&image->elem);
+          if (image->write_cnt == inode_write_cnt (inode))
+            {
+              list_push_front (&image_cache, &image->elem);
+              image->ref_cnt++;
+              lock_release (&image_lock);
+              return image;
+            }
+
+          /* Stale. */
+          image_cnt--;
+          lock_release (&image_lock);
+          image_release (image);
+          lock_acquire (&image_lock);
+          break;
+        }
+    }
+  lock_release (&image_lock);
+
   /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
       || ehdr.e_type != 2
       || ehdr.e_machine != 3
@@ -360,21 +671,27 @@ load (const char *file_name, void (**eip) (void), void **esp)
       || ehdr.e_phnum > 1024) 
     {
       printf ("load: %s: error loading executable\n", file_name);
-      goto done; 
+      return NULL;
     }
+
+  image = malloc (sizeof *image + ehdr.e_phnum * sizeof *image->segments);
+  if (image == NULL)
+    return NULL;
+  image->entry = (void (*) (void)) ehdr.e_entry;
+  image->segment_cnt = 0;
  
   /* Read program headers. */
   file_ofs = ehdr.e_phoff;
   for (i = 0; i < ehdr.e_phnum; i++) 
     {
       struct Elf32_Phdr phdr;
+      struct segment *seg;
+      uint32_t page_offset;
  
       if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
-      file_seek (file, file_ofs);
- 
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+        goto error;
+      if (file_read_at (file, &phdr, sizeof phdr, file_ofs) != sizeof phdr)
+        goto error;
       file_ofs += sizeof phdr;
       switch (phdr.p_type) 
         {
@@ -388,59 +705,94 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          goto error;
         case PT_LOAD:
-          if (validate_segment (&phdr, file)) 
+          if (!validate_segment (&phdr, file)) 
+            goto error;
+          seg = &image->segments[image->segment_cnt++];
+          seg->writable = (phdr.p_flags & PF_W) != 0;
+          seg->file_page = phdr.p_offset & ~PGMASK;
+          seg->mem_page = phdr.p_vaddr & ~PGMASK;
+          page_offset = phdr.p_vaddr & PGMASK;
+          if (phdr.p_filesz > 0)
+            {
+              /* Normal segment.
+                 Read initial part from disk and zero the rest. */
+              seg->read_bytes = page_offset + phdr.p_filesz;
+              seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz,
+                                           PGSIZE)
+                                 - seg->read_bytes);
+            }
+          else 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
-              uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
-              if (phdr.p_filesz > 0)
-                {
-                  /* Normal segment.
-                     Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
-                }
-              else 
-                {
-                  /* Entirely zero.
-                     Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
-                }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
+              /* Entirely zero.
+                 Don't read anything from disk. */
+              seg->read_bytes = 0;
+              seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
             }
-          else
-            goto done;
           break;
         }
     }
- 
-  /* Set up stack. */
-  if (!setup_stack (esp, file_name))
-    goto done;
- 
-  /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
- 
-  success = true;
- 
- done:
-  palloc_free_page(filename);
-  palloc_free_page(actualFileName);
-  return success;
 
-  //Brock done driving
+  /* Add to the cache, unless another process beat us to it,
+     evicting the least recently used image if it is full.  The
+     file has writes denied, so its write count cannot have
+     changed since we started reading. */
+  image->inode = inode_reopen (inode);
+  image->write_cnt = inode_write_cnt (inode);
+  image->ref_cnt = 2;
+  lock_acquire (&image_lock);
+  for (e = list_begin (&image_cache); e != list_end (&image_cache);
+       e = list_next (e))
+    if (list_entry (e, struct image, elem)->inode == inode)
+      {
+        image->ref_cnt = 1;
+        break;
+      }
+  if (image->ref_cnt == 2)
+    {
+      struct image *victim = NULL;
+      if (image_cnt == IMAGE_CACHE_MAX)
+        {
+          victim = list_entry (list_pop_back (&image_cache),
+                               struct image, elem);
+          image_cnt--;
+        }
+      list_push_front (&image_cache, &image->elem);
+      image_cnt++;
+      lock_release (&image_lock);
+      if (victim != NULL)
+        image_release (victim);
+    }
+  else
+    lock_release (&image_lock);
+  return image;
+
+ error:
+  free (image);
+  return NULL;
 }
-/* load() helpers. */
- 
+
+/* Drops a reference to IMAGE, freeing it and closing its inode
+   once it is neither in the cache nor in use. */
+static void
+image_release (struct image *image)
+{
+  int ref_cnt;
+
+  lock_acquire (&image_lock);
+  ref_cnt = --image->ref_cnt;
+  lock_release (&image_lock);
+
+  if (ref_cnt == 0)
+    {
+      inode_close (image->inode);
+      free (image);
+    }
+}
+
 static bool install_page (void *upage, void *kpage, bool writable);
+static bool install_cow_page (void *upage, void *kpage);
  
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -509,7 +861,6 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
  
-  file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
       /* Calculate how to fill this page.
@@ -517,30 +868,55 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
          and zero the final PAGE_ZERO_BYTES bytes. */
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
+      bool copy_on_write = false;
+      uint8_t *kpage;
  
-      /* Get a page of memory. */
-      uint8_t *kpage = palloc_get_page (PAL_USER);
-      if (kpage == NULL)
-        return false;
- 
-      /* Load this page. */
-      if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes)
+      if (page_read_bytes == 0)
         {
-          palloc_free_page (kpage);
-          return false; 
+          /* An all-zero page, typically BSS, maps the shared zero
+             frame and gets a frame of its own only if the process
+             ever writes to it. */
+          kpage = frame_get_zero ();
+          copy_on_write = writable;
+        }
+      else if (!writable)
+        {
+          /* Read-only pages are shared with every other process
+             running this executable. */
+          kpage = frame_get_shared (file, ofs, page_read_bytes);
+          if (kpage == NULL)
+            return false;
+        }
+      else
+        {
+          /* Get a page of memory. */
+          kpage = frame_alloc (0);
+          if (kpage == NULL)
+            return false;
+ 
+          /* Load this page. */
+          if (file_read_at (file, kpage, page_read_bytes, ofs)
+              != (int) page_read_bytes)
+            {
+              frame_free (kpage);
+              return false; 
+            }
+          memset (kpage + page_read_bytes, 0, page_zero_bytes);
         }
-      memset (kpage + page_read_bytes, 0, page_zero_bytes);
  
       /* Add the page to the process's address space. */
-      if (!install_page (upage, kpage, writable)) 
+      if (copy_on_write
+          ? !install_cow_page (upage, kpage)
+          : !install_page (upage, kpage, writable)) 
         {
-          palloc_free_page (kpage);
+          frame_free (kpage);
           return false; 
         }
  
       /* Advance. */
       read_bytes -= page_read_bytes;
       zero_bytes -= page_zero_bytes;
+      ofs += PGSIZE;
       upage += PGSIZE;
     }
   
@@ -579,7 +955,7 @@ setup_stack (void **esp, const char* file_name)
   uint8_t *kpage;
   bool success = false;
   
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  kpage = frame_alloc (PAL_ZERO);
   if (kpage != NULL) 
     {
       success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
@@ -703,7 +1079,7 @@ setup_stack (void **esp, const char* file_name)
         //Brock done driving
         }
       else
-        palloc_free_page (kpage);
+        frame_free (kpage);
       }
   
   return success;
@@ -726,8 +1102,22 @@ install_page (void *upage, void *kpage, bool writable)
  
   /* Verify that there's not already a page at that virtual
      address, then map our page there. */
-  return (pagedir_get_page (t->pagedir, upage) == NULL
-          && pagedir_set_page (t->pagedir, upage, kpage, writable));
+  if (pagedir_get_page (t->pagedir, upage) != NULL
+      || !pagedir_set_page (t->pagedir, upage, kpage, writable))
+    return false;
+  frame_map (kpage, t->pagedir, upage);
+  return true;
 }
  
 
+/* Like install_page(), but maps UPAGE to KPAGE read-only and
+   copy-on-write, so that the process gets a private, writable
+   copy of the page the first time it writes to it. */
+static bool
+install_cow_page (void *upage, void *kpage)
+{
+  struct thread *t = thread_current ();
+
+  return (pagedir_get_page (t->pagedir, upage) == NULL
+          && pagedir_set_page_cow (t->pagedir, upage, kpage));
+}
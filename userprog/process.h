@@ -3,9 +3,19 @@
 
 #include "threads/thread.h"
 
+struct intr_frame;
+
+/* If true, print each process's virtual memory statistics when
+   it exits.  Controlled by kernel command-line option "-vmstat". */
+extern bool process_print_vmstat;
+
+void process_init (void);
 tid_t process_execute (const char *file_name);
+tid_t process_fork (struct intr_frame *);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+void process_write_stdout (const char *, size_t);
+void process_flush_stdout (void);
 
 #endif /* userprog/process.h */
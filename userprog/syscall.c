@@ -1,23 +1,123 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include <uio.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "userprog/pagedir.h"
 #include "threads/vaddr.h"
+#include "devices/input.h"
 #include "devices/shutdown.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
 #include "threads/synch.h"
 #include "filesys/directory.h"
 #include "filesys/inode.h"
+#include "userprog/process.h"
+#include "userprog/fdtable.h"
+#include "userprog/usermem.h"
 
 #define ERROR -1  /* Used when a pointer or file is invalid */
 #define STDIN 0   /* Standard Input File Descriptor */
 #define STDOUT 1  /* Standard Output File Descriptor */
 #define STDERR 2  /* Standard Error File Descriptor */
 
+/* Most arguments any system call takes. */
+#define SYSCALL_MAX_ARGS 4
+
+/* How a system call argument is checked by syscall_handler()
+   before the call itself runs.  A process that passes an
+   argument that fails its check exits with -1 status. */
+enum arg_kind
+  {
+    ARG_INT,            /* Any integer; the call checks it if needed. */
+    ARG_FD,             /* Descriptor of an open file, not the console. */
+    ARG_STRING,         /* Null-terminated user string. */
+    ARG_BUFFER,         /* User buffer read by the call. */
+    ARG_OUT_BUFFER,     /* User buffer written by the call. */
+    ARG_SIZE,           /* Size of the buffer in the previous argument. */
+    ARG_PTR             /* User pointer the call copies in or out itself. */
+  };
+
+/* Carries out a system call, given interrupt frame F and the
+   call's arguments ARGS, already checked, and returns the value
+   for the process's eax. */
+typedef uint32_t syscall_func (struct intr_frame *f, const uint32_t *args);
+
+/* A system call. */
+struct syscall
+  {
+    const char *name;                   /* Name, for statistics. */
+    syscall_func *func;                 /* Implementation. */
+    int arg_cnt;                        /* Number of arguments. */
+    enum arg_kind args[SYSCALL_MAX_ARGS]; /* Kind of each argument. */
+
+    /* Statistics. */
+    long long call_cnt;                 /* Number of calls. */
+    uint64_t cycles;                    /* Cycles spent in calls. */
+  };
+
+static syscall_func sys_halt, sys_exit, sys_exec, sys_wait, sys_create,
+  sys_remove, sys_open, sys_filesize, sys_read, sys_write, sys_seek,
+  sys_tell, sys_close, sys_chdir, sys_mkdir, sys_readdir, sys_isdir,
+  sys_inumber, sys_fork, sys_vmstat, sys_readv, sys_writev,
+  sys_pread, sys_pwrite, sys_copy_file_range, sys_batch_setup,
+  sys_batch_enter;
+
+/* System calls, indexed by number.  Numbers without an
+   implementation, such as those for memory mapping, have a null
+   FUNC. */
+static struct syscall syscalls[] =
+  {
+    [SYS_HALT] = {"halt", sys_halt, 0, {}},
+    [SYS_EXIT] = {"exit", sys_exit, 1, {ARG_INT}},
+    [SYS_EXEC] = {"exec", sys_exec, 1, {ARG_STRING}},
+    [SYS_WAIT] = {"wait", sys_wait, 1, {ARG_INT}},
+    [SYS_CREATE] = {"create", sys_create, 2, {ARG_STRING, ARG_INT}},
+    [SYS_REMOVE] = {"remove", sys_remove, 1, {ARG_STRING}},
+    [SYS_OPEN] = {"open", sys_open, 1, {ARG_STRING}},
+    [SYS_FILESIZE] = {"filesize", sys_filesize, 1, {ARG_FD}},
+    [SYS_READ] = {"read", sys_read, 3, {ARG_INT, ARG_OUT_BUFFER, ARG_SIZE}},
+    [SYS_WRITE] = {"write", sys_write, 3, {ARG_INT, ARG_BUFFER, ARG_SIZE}},
+    [SYS_SEEK] = {"seek", sys_seek, 2, {ARG_FD, ARG_INT}},
+    [SYS_TELL] = {"tell", sys_tell, 1, {ARG_FD}},
+    [SYS_CLOSE] = {"close", sys_close, 1, {ARG_FD}},
+    [SYS_CHDIR] = {"chdir", sys_chdir, 1, {ARG_STRING}},
+    [SYS_MKDIR] = {"mkdir", sys_mkdir, 1, {ARG_STRING}},
+    [SYS_READDIR] = {"readdir", sys_readdir, 2, {ARG_FD, ARG_PTR}},
+    [SYS_ISDIR] = {"isdir", sys_isdir, 1, {ARG_FD}},
+    [SYS_INUMBER] = {"inumber", sys_inumber, 1, {ARG_FD}},
+    [SYS_FORK] = {"fork", sys_fork, 0, {}},
+    [SYS_VMSTAT] = {"vmstat", sys_vmstat, 1, {ARG_PTR}},
+    [SYS_READV] = {"readv", sys_readv, 3, {ARG_FD, ARG_PTR, ARG_INT}},
+    [SYS_WRITEV] = {"writev", sys_writev, 3, {ARG_INT, ARG_PTR, ARG_INT}},
+    [SYS_PREAD] = {"pread", sys_pread, 4,
+                   {ARG_FD, ARG_OUT_BUFFER, ARG_SIZE, ARG_INT}},
+    [SYS_PWRITE] = {"pwrite", sys_pwrite, 4,
+                    {ARG_FD, ARG_BUFFER, ARG_SIZE, ARG_INT}},
+    [SYS_COPY_FILE_RANGE] = {"copy_file_range", sys_copy_file_range, 3,
+                             {ARG_FD, ARG_FD, ARG_INT}},
+    [SYS_BATCH_SETUP] = {"batch_setup", sys_batch_setup, 1, {ARG_PTR}},
+    [SYS_BATCH_ENTER] = {"batch_enter", sys_batch_enter, 0, {}},
+  };
+
+/* Number of entries in syscalls[]. */
+#define SYSCALL_CNT (sizeof syscalls / sizeof *syscalls)
+
 static void syscall_handler (struct intr_frame *);
+static uint32_t run_syscall (struct intr_frame *, struct syscall *,
+                             const uint32_t *args);
+static void check_args (const struct syscall *, const uint32_t *args);
+
+/* Returns the processor's time-stamp counter. */
+static inline uint64_t
+read_tsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
 
 //Viren driving now
 
@@ -29,41 +129,101 @@ void valid_pointer_check(void * ptr)
   // If the pointer is null or it is a kernel and not user address 
   // or if address is unmapped, exit with -1 error status.
   // Otherwise, nothing happens.
+  // A page that is swapped out still counts as mapped; touching
+  // it just faults it back in.
   if(ptr == NULL || is_kernel_vaddr (ptr) || 
-  pagedir_get_page(thread_current()->pagedir, ptr) == NULL)
+  !pagedir_is_mapped(thread_current()->pagedir, ptr))
     {
       exit(ERROR);
     }
 }
 
-/* This is a helper method used for checking if given fd is between 
-curr_file_index and the least possible fd value it could be (0 or 2).
-if it isn't, exit with -1 status. Parameters are t or the current 
-thread, the given fd, and the low_limit (either 0 or 2). */
-void fd_exist_check(struct thread *t, int fd, int low_limit)
+/* Used to check if file exists or not. Used in case where 
+fd is valid but file was closed earlier. Only parameter is the respective
+file to check. If it is NULL, exit with -1 error status. */
+void file_exist_check(struct file *f) 
+{
+  if(f == NULL)
+  {
+    exit(ERROR);
+  }
+}
+
+/* Checks that all SIZE bytes of BUFFER are mapped user memory,
+writable too if WRITABLE, so the call can use it directly.
+Exits with -1 status if not. */
+static void buffer_check(const void *buffer, unsigned size, bool writable)
 {
-  // A simple check to see if file exists or not based on given fd.
-  if(fd < low_limit || fd >= t->curr_file_index) 
+  if(buffer == NULL || !check_user_range(buffer, size, writable))
   {
     exit(ERROR);
   }
 }
 
-/* Used to check if file exists or not. Used in case where 
-fd is valid but file was closed earlier. Only parameter is the respective
-file to check. If it is NULL, exit with -1 error status. */
-void file_exist_check(struct file *f) 
+/* Checks that STR is a null-terminated string in user memory.
+Exits with -1 status if not. */
+static void string_check(const char *str)
 {
-  if(f == NULL)
+  if(!check_user_string(str))
+  {
+    exit(ERROR);
+  }
+}
+
+/* Returns the current process's open file for FD. Exits with -1
+status if FD isn't open, or isn't a file at all, like the
+console's descriptors. */
+static struct file *fd_file(int fd)
+{
+  struct file *file = fd_table_get(&thread_current()->fds, fd);
+  // Also catches a file with valid fd that was closed earlier.
+  file_exist_check(file);
+  return file;
+}
+
+/* Copies element I of the user's iovec array IOV into *V and
+checks its buffer, which must be writable if WRITABLE. Exits
+with -1 status if either is bad. */
+static void iovec_get(const struct iovec *iov, int i, struct iovec *v,
+                      bool writable)
+{
+  if(!copy_in(v, iov + i, sizeof *v))
   {
     exit(ERROR);
   }
+  if(v->iov_len > 0)
+    buffer_check(v->iov_base, v->iov_len, writable);
+}
+
+/* Reads up to SIZE bytes of keyboard or serial input into the
+user's BUFFER, which has been checked. Waits for the first byte,
+then takes whatever else is already there, in bulk, up to and
+including the end of the line, so that a line that has been typed
+or pasted in is read with one call. Returns the number of bytes
+read. */
+static int stdin_read(uint8_t *buffer, unsigned size)
+{
+  unsigned total = 0;
+
+  while(total < size)
+  {
+    uint8_t keys[64];
+    size_t chunk = size - total < sizeof keys ? size - total : sizeof keys;
+    size_t cnt = input_read_line(keys, chunk);
+
+    memcpy(buffer + total, keys, cnt);
+    total += cnt;
+    // Stop at the end of a line, or rather than wait for more.
+    if(keys[cnt - 1] == '\r' || keys[cnt - 1] == '\n' || input_empty())
+      break;
+  }
+  return total;
 }
 
 //Viren done driving
 
 void
-syscall_init (void) 
+syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
   // This is where we initialize our locks.
@@ -71,428 +231,641 @@ syscall_init (void)
   lock_init(&write_lock);
 }
 
+/* Prints the number of calls to, and average cycles spent in,
+   each system call that has been used. */
+void
+syscall_print_stats (void)
+{
+  size_t i;
+
+  for (i = 0; i < SYSCALL_CNT; i++)
+    {
+      const struct syscall *sc = &syscalls[i];
+      if (sc->call_cnt > 0)
+        printf ("Syscall: %s %lld calls, %llu cycles each\n",
+                sc->name, sc->call_cnt, sc->cycles / sc->call_cnt);
+    }
+}
+
 //Jasper driving now
 
-/* This is our exit helper method 
-that is used for when a thread 
+/* This is our exit helper method
+that is used for when a thread
 exits and to retrieve its status
 before doing so. Status lock is used
 to ensure that this is done atomically. */
-void exit(int status) 
+void exit(int status)
 {
   thread_current()->exit_status = status;
-  
-  //close this thread's executable (allows writes)
-  //lock_acquire(&file_lock);
-  file_close(thread_current()->executable);
-  //lock_release(&file_lock);
 
+  // The executable is closed (allowing writes) by process_exit().
   thread_exit();
 }
 
 //Jasper done driving
 
-/* This method is used to handle all the system calls and do
-what is required respectively. */
+/* This method is used to handle all the system calls. It looks
+up the call in the syscalls table, copies in all of its arguments
+at once, checks each according to its kind, and then runs the
+call, timing it. */
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+syscall_handler (struct intr_frame *f)
 {
   //Jordan driving now
 
-  // A temporary stack pointer so actual
-  // stack pointer isn't modified directly.
-  char *temp_esp = f->esp;
-  valid_pointer_check(temp_esp);
+  uint32_t args[SYSCALL_MAX_ARGS];
+  uint32_t sys_call_num;
+  struct syscall *sc;
 
-  int sys_call_num = *(int *)temp_esp;
-  switch(sys_call_num) 
+  // An unknown or unimplemented system call is treated like a
+  // bad pointer.
+  if(!copy_in(&sys_call_num, f->esp, sizeof sys_call_num)
+     || sys_call_num >= SYSCALL_CNT || syscalls[sys_call_num].func == NULL)
+  {
+    exit(ERROR);
+  }
+  sc = &syscalls[sys_call_num];
+  if(!copy_in(args, (uint32_t *) f->esp + 1, sc->arg_cnt * sizeof *args))
   {
+    exit(ERROR);
+  }
 
-    // System call where Pintos is terminated.
-    case SYS_HALT:
-      shutdown_power_off();
-      break;
+  // Console output is line buffered per process. Anything else
+  // the process does may be observable, so write out any pending
+  // partial line first.
+  if (sys_call_num != SYS_WRITE && sys_call_num != SYS_WRITEV)
+    process_flush_stdout();
 
-    //Jordan done driving
-    //Brock driving now
-    // System call that terminates current user program, returning 
-    // its exit status to the kernel. Usually 0 if successful
-    // and -1 or some other nonzero value if not.
-    case SYS_EXIT:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int status = *(int *) temp_esp;
-      exit(status);
-      break;
-    
-    // System call that runs the executable based off name
-    // given in the cmd_line argument. Process's pid is 
-    // returned or -1 if can't load or run.
-    case SYS_EXEC:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      char * cmd_line = *(int *) temp_esp; 
-      valid_pointer_check(cmd_line);
-      tid_t child_tid = process_execute(cmd_line);
-      //block the child's exec semaphore until after 
-      //the process has been loaded
-      sema_down(&get_thread_from_tid(child_tid)->exec_sema);
-      //return -1 if child didn't load properly
-      if(!get_thread_from_tid(child_tid)->childLoaded) 
-        child_tid = ERROR;
-      f->eax = child_tid;
-      break;
+  f->eax = run_syscall(f, sc, args);
+
+  //Jordan done driving
+}
 
-    //Brock done driving
-    //Viren driving now
-    // System call where process waits for a child process pid 
-    // and retrieve's its exit status. -1 returned if process_wait
-    // fails.
-    case SYS_WAIT:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      tid_t pid = *(int *) temp_esp;
-      f->eax = process_wait(pid);
+/* Checks ARGS, the arguments to system call SC, then runs it,
+counting and timing the call, and returns its result. */
+static uint32_t
+run_syscall (struct intr_frame *f, struct syscall *sc, const uint32_t *args)
+{
+  enum intr_level old_level;
+  uint64_t start;
+  uint32_t result;
+
+  check_args(sc, args);
+
+  // Count the call before running it, since exit never returns.
+  old_level = intr_disable();
+  sc->call_cnt++;
+  intr_set_level(old_level);
+
+  start = read_tsc();
+  result = sc->func(f, args);
+
+  old_level = intr_disable();
+  sc->cycles += read_tsc() - start;
+  intr_set_level(old_level);
+
+  return result;
+}
+
+/* Checks each of the ARGS to system call SC according to its
+kind. Exits with -1 status if any is invalid. */
+static void
+check_args (const struct syscall *sc, const uint32_t *args)
+{
+  int i;
+
+  for(i = 0; i < sc->arg_cnt; i++)
+  {
+    switch(sc->args[i])
+    {
+      case ARG_INT:
+      case ARG_SIZE:
+      case ARG_PTR:
+        break;
+
+      // The descriptor has to be open.
+      case ARG_FD:
+        fd_file((int) args[i]);
+        break;
+
+      case ARG_STRING:
+        string_check((const char *) args[i]);
+        break;
+
+      // A buffer is checked over its whole size, which is the
+      // next argument.
+      case ARG_BUFFER:
+      case ARG_OUT_BUFFER:
+        ASSERT(i + 1 < sc->arg_cnt && sc->args[i + 1] == ARG_SIZE);
+        buffer_check((const void *) args[i], args[i + 1],
+                     sc->args[i] == ARG_OUT_BUFFER);
+        break;
+    }
+  }
+}
+
+//Jordan driving now
+
+// System call where Pintos is terminated.
+static uint32_t
+sys_halt (struct intr_frame *f UNUSED, const uint32_t *args UNUSED)
+{
+  shutdown_power_off();
+}
+
+//Jordan done driving
+//Brock driving now
+
+// System call that terminates current user program, returning
+// its exit status to the kernel. Usually 0 if successful
+// and -1 or some other nonzero value if not.
+static uint32_t
+sys_exit (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  exit((int) args[0]);
+  NOT_REACHED();
+}
+
+// System call that runs the executable based off name
+// given in the cmd_line argument. Process's pid is
+// returned or -1 if can't load or run.
+static uint32_t
+sys_exec (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  tid_t child_tid = process_execute((const char *) args[0]);
+  struct exit_record *rec;
+
+  if(child_tid == TID_ERROR)
+    return ERROR;
+  //wait on the child's exit record until after
+  //the process has been loaded
+  rec = thread_child(child_tid);
+  sema_down(&rec->load_sema);
+  //return -1 if child didn't load properly, and forget
+  //the child since its pid is never handed out
+  if(!rec->loaded)
+  {
+    list_remove(&rec->elem);
+    exit_record_release(rec);
+    child_tid = ERROR;
+  }
+  return child_tid;
+}
+
+//Brock done driving
+//Viren driving now
+
+// System call where process waits for a child process pid
+// and retrieve's its exit status. -1 returned if process_wait
+// fails.
+static uint32_t
+sys_wait (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  return process_wait((tid_t) args[0]);
+}
+
+// System call where a new file is created with a certain
+// initial size. True if successful, false if not.
+// Since creating a file does not open it, we don't store
+// it in our array of files opened.
+static uint32_t
+sys_create (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  return filesys_create((const char *) args[0], args[1]);
+}
+
+//Viren done driving
+//Jasper driving now
+
+// System call that deletes the given file. True if successful,
+// false if not. Since a file can be removed regardless of whether
+// it is open or not, we don't modify our array of files opened.
+static uint32_t
+sys_remove (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  return filesys_remove((const char *) args[0]);
+}
+
+// System call opens a file. The lowest free file descriptor, which
+// it was added under in the process's table of open files, is
+// returned or -1 if file could not be opened or was NULL.
+static uint32_t
+sys_open (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  struct file *open_file = filesys_open((const char *) args[0]);
+  int fd;
+
+  if(open_file == NULL)
+    return ERROR;
+
+  //add this file to thread's table of open files
+  fd = fd_table_add(&thread_current()->fds, open_file);
+  if(fd < 0)
+    file_close(open_file);
+  return fd;
+}
+
+//Jasper done driving
+//Jordan driving now
+
+// System call that returns the size of the open file.
+static uint32_t
+sys_filesize (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  return file_length(fd_file(args[0]));
+}
+
+// System call that reads a certain number of bytes of open file
+// into buffer. Returns number of bytes read or -1 if file could not
+// be read besides it being at the end of file.
+static uint32_t
+sys_read (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  int fd_read = (int) args[0];
+  void *buffer = (void *) args[1];
+  unsigned size = args[2];
+
+  //case where fd is 0 and we are reading from user
+  if(fd_read == STDIN)
+    return stdin_read(buffer, size);
+
+  //exit with error if paramater fd is not a valid file
+  return file_read(fd_file(fd_read), buffer, size);
+}
+
+//Jordan done driving
+//Brock driving now
+
+// System call that writes a certain amount of bytes from buffer
+// to the open file designated by file descriptor. Returns number
+// of bytes written or 0 if none could be written.
+static uint32_t
+sys_write (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  int fd_write = (int) args[0];
+  const void *buffer_write = (const void *) args[1];
+  unsigned size_write = args[2];
+
+  //when fd is 1 write to the console through the process's
+  //line buffer
+  if(fd_write == STDOUT)
+  {
+    lock_acquire(&write_lock);
+    process_write_stdout(buffer_write, size_write);
+    lock_release(&write_lock);
+    return size_write;
+  }
+  //nothing can be written to standard input
+  if(fd_write == STDIN)
+    return 0;
+
+  //other cases when writing to a file, exiting with error if
+  //fd is not a valid file
+  return file_write(fd_file(fd_write), buffer_write, size_write);
+}
+
+// System call that changes the next byte to be read or written
+// in open file designated by given file descriptor, relative to
+// bytes from beginning of file.
+static uint32_t
+sys_seek (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  file_seek(fd_file(args[0]), args[1]);
+  return 0;
+}
+
+//Brock done driving
+//Viren driving now
+
+// System call returns position of next byte to be read or written
+// in open file designated by given file descriptor, relative to bytes
+// from beginning of file.
+static uint32_t
+sys_tell (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  return file_tell(fd_file(args[0]));
+}
+
+// System call closes the open file with given file descriptor.
+static uint32_t
+sys_close (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  // Removing the file frees its descriptor for the next open.
+  file_close(fd_table_remove(&thread_current()->fds, (int) args[0]));
+  return 0;
+}
+
+// Viren done driving,
+// Jordan driving now.
+
+/* This System call changes the current working directory to specified
+directory, be it relative or absolute path. True returned if successful,
+false otherwise. */
+static uint32_t
+sys_chdir (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  return filesys_chdir((const char *) args[0]);
+}
+
+/* This system call creates a directory. True returned if successful,
+false otherwise. */
+static uint32_t
+sys_mkdir (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  return mkdir((const char *) args[0]);
+}
+
+//Jordan done driving,
+// Jasper driving now.
+
+/* This system call reads a directory based on the given file descriptor
+passed in. Returns true if done right, false otherwise. The name is
+read into a kernel buffer and then copied out to the user's. */
+static uint32_t
+sys_readdir (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  struct file *file_to_readdir = fd_file(args[0]);
+  char name[NAME_MAX + 1];
+
+  // If inode is not a directory, we exit with -1 error status.
+  // Otherwise, cast specfiied file to a directory and then
+  // the return value is result of dir_readdir call with
+  // respective directory and its name passed in.
+  if(!inode_is_dir(file_get_inode(file_to_readdir)))
+    exit(ERROR);
+  if(!dir_readdir((struct dir *) file_to_readdir, name))
+    return false;
+  if(!copy_out((char *) args[1], name, strlen(name) + 1))
+    exit(ERROR);
+  return true;
+}
+
+// Jasper done driving,
+// Brock driving now.
+
+/* This system call returns whether the given file based on the file
+descriptor is a directory (true returned) or a file (false is returned) */
+static uint32_t
+sys_isdir (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  // Simply call our inodeisdir method here.
+  return inode_is_dir(file_get_inode(fd_file(args[0])));
+}
+
+// Brock done driving,
+// Viren driving now.
+
+/* This system call returns the inode number of the inode
+corresponding with the given file descriptor. */
+static uint32_t
+sys_inumber (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  // Simply call the inumber method here.
+  return inode_get_inumber(file_get_inode(fd_file(args[0])));
+}
+
+/* This system call duplicates the calling process. The child's
+pid is returned to the parent and 0 to the child, or -1 if the
+child could not be created. */
+static uint32_t
+sys_fork (struct intr_frame *f, const uint32_t *args UNUSED)
+{
+  return process_fork(f);
+}
+
+// Copies the process's virtual memory statistics out to
+// the given buffer, which may straddle a page boundary.
+static uint32_t
+sys_vmstat (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  if(!copy_out((struct vmstat *) args[0], &thread_current()->vmstat,
+               sizeof (struct vmstat)))
+    exit(ERROR);
+  return 0;
+}
+
+/* Reads from the file with the given descriptor into each of
+the IOVCNT buffers described by the iovec array in turn, in a
+single system call. Stops early at end of file. Returns the
+total number of bytes read, or -1 if IOVCNT is out of range. */
+static uint32_t
+sys_readv (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  struct file *file = fd_file(args[0]);
+  const struct iovec *iov = (const struct iovec *) args[1];
+  int iovcnt = (int) args[2];
+  int total = 0;
+  int i;
+
+  if(iovcnt < 0 || iovcnt > IOV_MAX)
+    return ERROR;
+
+  for(i = 0; i < iovcnt; i++)
+  {
+    struct iovec v;
+    int bytes_read;
+
+    iovec_get(iov, i, &v, true);
+    bytes_read = file_read(file, v.iov_base, v.iov_len);
+    total += bytes_read;
+    if((size_t) bytes_read < v.iov_len)
       break;
-    
-    // System call where a new file is created with a certain 
-    // initial size. True if successful, false if not. 
-    // Since creating a file does not open it, we don't store
-    // it in our array of files opened.
-    case SYS_CREATE:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      char * file = *(int *) temp_esp;
-      valid_pointer_check(file);
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      uint32_t initial_size = *(int *) temp_esp;
-      
-      //use synchronization with the file lock when
-      //accessing the file system
-      //lock_acquire(&file_lock);
-      f->eax = filesys_create(file, initial_size);
-      //lock_release(&file_lock);
+  }
+  return total;
+}
+
+/* Writes each of the IOVCNT buffers described by the iovec array
+in turn to the file with the given descriptor, or to the console
+for standard output, in a single system call. Stops early if a
+file can't be extended. Returns the total number of bytes written,
+or -1 if IOVCNT is out of range. */
+static uint32_t
+sys_writev (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  int fd = (int) args[0];
+  const struct iovec *iov = (const struct iovec *) args[1];
+  int iovcnt = (int) args[2];
+  struct file *file = NULL;
+  int total = 0;
+  int i;
+
+  if(iovcnt < 0 || iovcnt > IOV_MAX)
+    return ERROR;
+
+  // Look the descriptor up once for all the buffers.
+  if(fd != STDOUT)
+    file = fd_file(fd);
+
+  for(i = 0; i < iovcnt; i++)
+  {
+    struct iovec v;
+    int bytes_written;
+
+    iovec_get(iov, i, &v, false);
+    if(file == NULL)
+    {
+      lock_acquire(&write_lock);
+      process_write_stdout(v.iov_base, v.iov_len);
+      lock_release(&write_lock);
+      bytes_written = v.iov_len;
+    }
+    else
+      bytes_written = file_write(file, v.iov_base, v.iov_len);
+    total += bytes_written;
+    if((size_t) bytes_written < v.iov_len)
       break;
+  }
+  return total;
+}
+
+/* Reads from the file with the given descriptor into the buffer,
+starting at the given offset rather than the file's position,
+which is left alone, so random access takes one call instead of a
+seek and a read. Returns the number of bytes read, or -1 for a negative offset. */
+static uint32_t
+sys_pread (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  off_t offset = (off_t) args[3];
+
+  if(offset < 0)
+    return ERROR;
+  return file_read_at(fd_file(args[0]), (void *) args[1], args[2], offset);
+}
+
+/* Writes the buffer to the file with the given descriptor,
+starting at the given offset rather than the file's position,
+which is left alone. Returns the number of bytes written, or -1
+for a negative offset or a directory. */
+static uint32_t
+sys_pwrite (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  off_t offset = (off_t) args[3];
+
+  if(offset < 0)
+    return ERROR;
+  return file_write_at(fd_file(args[0]), (const void *) args[1], args[2],
+                       offset);
+}
 
-    //Viren done driving
-    //Jasper driving now
-    // System call that deletes the given file. True if successful,
-    // false if not. Since a file can be removed regardless of whether
-    // it is open or not, we don't modify our array of files opened.
+/* Copies up to the given number of bytes from the first file
+descriptor's file to the second's, each at its current position,
+inside the kernel, so the data never passes through a user buffer.
+Returns the number of bytes copied, 0 at end of file, or -1 if
+the output is a directory, both descriptors refer to the same file
+(even through different opens, since the ranges could overlap), or
+kernel memory is short. */
+static uint32_t
+sys_copy_file_range (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  // A larger size than a file can hold just means "all of it".
+  off_t size = args[2] > INT32_MAX ? INT32_MAX : (off_t) args[2];
+
+  return file_copy(fd_file(args[1]), fd_file(args[0]), size);
+}
+
+/* Registers the given batch ring, which must be writable user
+memory, for later batch_enter calls, replacing any ring registered
+before. A null pointer unregisters the ring. Returns true if
+successful, false if the ring is not in user memory. */
+static uint32_t
+sys_batch_setup (struct intr_frame *f UNUSED, const uint32_t *args)
+{
+  struct batch_ring *ring = (struct batch_ring *) args[0];
+
+  if(ring != NULL && !check_user_range(ring, sizeof *ring, true))
+    return false;
+  thread_current()->batch_ring = ring;
+  return true;
+}
+
+/* Returns true if system call SQE may be made through a batch ring.
+Those are the calls on files, which neither end nor replace the
+process nor wait on another. A read from the keyboard could wait
+forever, so it is not allowed either. */
+static bool
+batchable (const struct batch_sqe *sqe)
+{
+  switch(sqe->nr)
+  {
+    case SYS_CREATE:
     case SYS_REMOVE:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      char * file_to_remove = *(int *) temp_esp;
-      valid_pointer_check(file_to_remove);
-      
-      //use synchronization with the file lock when
-      //accessing the file system
-      //lock_acquire(&file_lock);
-      f->eax = filesys_remove(file_to_remove);
-      //lock_release(&file_lock);
-      break;
-    
-    // System call opens a file. The file descriptor or index in the array
-    // of open files that it was added in is returned or -1 if file
-    // could not be opened or was NULL.
     case SYS_OPEN:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      char * file_to_open = *(int *)temp_esp;
-      valid_pointer_check(file_to_open);
-      
-      //use synchronization with the file lock when
-      //accessing the file system
-      //lock_acquire(&file_lock);
-      struct file *open_file = filesys_open(file_to_open);
-      //lock_release(&file_lock);
-      
-      if(open_file == NULL) 
-      {
-        f->eax = ERROR;
-      } 
-      else 
-      {
-        struct thread *t = thread_current();
-        //add this file to thread's array of open files
-        t->set_of_files[t->curr_file_index] = open_file;
-        f->eax = t->curr_file_index; //return fd
-        t->curr_file_index++; //increment fd
-      }
-      break;
-
-    //Jasper done driving
-    //Jordan driving now
-    // System call that returns the size of the open file. Do a check
-    // to see if file would exist at given fd. If not, exit with error
-    // status. Otherwise, get file at spot file descriptor indexes into
-    // and get the size.
+    case SYS_CLOSE:
     case SYS_FILESIZE:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd = *(int *) temp_esp;
-      struct thread *t_size = thread_current();
-      //exit with error if paramater fd is not a valid file
-      fd_exist_check(t_size, fd, STDERR);
-      struct file *file_at_fd = t_size->set_of_files[fd];
-      // Additional check done in case a file with valid fd
-      // was closed earlier, so exit with -1 error status
-      // when such a thing happens.
-      file_exist_check(file_at_fd);
-      //use synchronization with the file lock when
-      //accessing the file system
-      //lock_acquire(&file_lock);
-      f->eax = file_length(file_at_fd);
-      //lock_release(&file_lock);
-      break;
-    
-    // System call that reads a certain number of bytes of open file
-    // into buffer. Returns number of bytes read or -1 if file could not
-    // be read besides it being at the end of file.
-    case SYS_READ:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_read = *(int *) temp_esp;
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      void *buffer = *(int *) temp_esp;
-      valid_pointer_check(buffer);
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      unsigned size = *(int *)temp_esp;
-      
-      struct thread *t_read = thread_current();
-      //case where fd is 0 and we are reading from user
-      if(fd_read == STDIN) 
-      {
-        f->eax = input_getc();
-        break;
-      }
-      //exit with error if paramater fd is not a valid file
-      fd_exist_check(t_read, fd_read, STDERR);
-      struct file *file_to_read = t_read->set_of_files[fd_read];
-      // Additional check done in case a file with valid fd
-      // was closed earlier, so exit with -1 error status
-      // when such a thing happens.
-      file_exist_check(file_to_read);
-      //use synchronization with the file lock when
-      //accessing the file system
-      //lock_acquire(&file_lock);
-      f->eax = file_read(file_to_read, buffer, size);
-      //lock_release(&file_lock);
-      break;
-
-    //Jordan done driving
-    //Brock driving now
-    // System call that writes a certain amount of bytes from buffer
-    // to the open file designated by file descriptor. Returns number
-    // of bytes written or 0 if none could be written.
     case SYS_WRITE:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_write = *(int *) temp_esp;
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      const void *buffer_write = *(int *) temp_esp;
-      valid_pointer_check(buffer_write);
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      unsigned size_write = *(int *)temp_esp;
-
-      struct thread *t_write = thread_current();
-      fd_exist_check(t_write, fd_write, STDIN);
-      struct file *file_to_write = t_write->set_of_files[fd_write];
-      
-      //when fd is 1 write to the console using putbuf
-      if(fd_write == STDOUT) 
-      {
-        lock_acquire(&write_lock);
-        putbuf((char *)buffer_write, size_write);
-        f->eax = size_write;
-        lock_release(&write_lock);
-      }
-      //other cases when writing to a file
-      else if(fd_write > STDOUT) 
-      {
-        // Additional check done in case a file with valid fd
-        // was closed earlier, so exit with -1 error status
-        // when such a thing happens.
-        file_exist_check(file_to_write);
-        //use synchronization with the file lock when
-        //accessing the file system
-        //lock_acquire(&file_lock);
-        f->eax = file_write(file_to_write, buffer_write, size_write);
-        //lock_release(&file_lock);
-      }
-      break;
-    
-    // System call that changes the next byte to be read or written 
-    // in open file designated by given file descriptor, relative to 
-    // bytes from beginning of file.
     case SYS_SEEK:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_seek = *(int *) temp_esp;
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      unsigned position = *(int *)temp_esp;
-      
-      struct thread *t_seek = thread_current();
-      fd_exist_check(t_seek, fd_seek, STDERR);
-      struct file *file_to_seek = t_seek->set_of_files[fd_seek];
-      // Additional check done in case a file with valid fd
-      // was closed earlier, so exit with -1 error status
-      // when such a thing happens.
-      file_exist_check(file_to_seek);
-      //use synchronization with the file lock when
-      //accessing the file system
-      //lock_acquire(&file_lock);
-      file_seek(file_to_seek, position);
-      //lock_release(&file_lock);
-      break;
-
-    //Brock done driving
-    //Viren driving now
-    // System call returns position of next byte to be read or written
-    // in open file designated by given file descriptor, relative to bytes
-    // from beginning of file.
     case SYS_TELL:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_tell = *(int *) temp_esp;
-      
-      struct thread *t_tell = thread_current();
-      fd_exist_check(t_tell, fd_tell, STDERR);
-      struct file *file_to_tell = t_tell->set_of_files[fd_tell];
-      // Additional check done in case a file with valid fd
-      // was closed earlier, so exit with -1 error status
-      // when such a thing happens.
-      file_exist_check(file_to_tell);
-      //use synchronization with the file lock when
-      //accessing the file system
-      f->eax = file_tell(file_to_tell);
-      break;
+    case SYS_PREAD:
+    case SYS_PWRITE:
+      return true;
+    case SYS_READ:
+      return (int) sqe->args[0] != STDIN;
+    default:
+      return false;
+  }
+}
 
-    // System call closes the open file with given file descriptor.
-    case SYS_CLOSE:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_close = *(int *) temp_esp;
-      
-      struct thread *t_close = thread_current();
-      fd_exist_check(t_close, fd_close, STDERR);
-      struct file *file_to_close = t_close->set_of_files[fd_close];
-      //null out file to be closed
-      t_close->set_of_files[fd_close] = NULL;
-      // Adjusts the current file descriptor index in the case that 
-      // the latest open file (curr_file_index - 1) was the one closed.
-      // If so, loop through and go down through a potential row of 
-      // consecutive closed files until standard error or 2.
-      if(fd_close == t_close->curr_file_index - 1) 
-      {
-        while(t_close->curr_file_index > STDERR && 
-        t_close->set_of_files[t_close->curr_file_index - 1] == NULL)
-        {
-          t_close->curr_file_index--;
-        }
-      }
-      //use synchronization with the file lock when
-      //accessing the file system
-      file_close(file_to_close);
-      break;
-    
-    // Viren done driving,
-    // Jordan driving now.
-    /* This System call changes the current working directory to specified 
-    directory, be it relative or absolute path. True returned if successful,
-    false otherwise. */
-    case SYS_CHDIR:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      char *dir = *(int *) temp_esp;
-      valid_pointer_check(dir);
-      f->eax = filesys_chdir(dir);
-      break;
-    
-    /* This system call creates a directory. True returned if successful,
-    false otherwise. */
-    case SYS_MKDIR:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      char *dir_mk = *(int *) temp_esp;
-      valid_pointer_check(dir_mk);
-      f->eax = mkdir(dir_mk);
-      break;
-    
-    //Jordan done driving,
-    // Jasper driving now.
-    /* This system call reads a directory based on the given file descriptor 
-    passed in. Returns true if done right, false otherwise.*/
-    case SYS_READDIR:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_readdir = *(int *) temp_esp;
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      char *name_readdir = *(int *) temp_esp;
-      valid_pointer_check(name_readdir);
-      struct thread *t_readdir = thread_current();
-      fd_exist_check(t_readdir, fd_readdir, STDERR);
-      struct file *file_to_readdir = t_readdir->set_of_files[fd_readdir];
-      // Additional check done in case a file with valid fd
-      // was closed earlier, so exit with -1 error status
-      // when such a thing happens.
-      file_exist_check(file_to_readdir);
-      // If inode is not a directory, we exit with -1 error status.
-      // Otherwise, cast specfiied file to a directory and then 
-      // the return value is result of dir_readdir call with
-      // respective directory and its name passed in.
-      if(!inode_is_dir(file_get_inode(file_to_readdir)))
-      {
-        exit(ERROR);
-      }
-      else
-      {
-        struct dir* dir_readir = (struct dir*) file_to_readdir;
-        f->eax = dir_readdir(dir_readir, name_readdir);
-      }
-    
-    // Jasper done driving,
-    // Brock driving now.
-    /* This system call returns whether the given file based on the file
-    descriptor is a directory (true returned) or a file (false is returned) */
-    case SYS_ISDIR:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_isdir = *(int *) temp_esp;
-      struct thread *t_isdir = thread_current();
-      fd_exist_check(t_isdir, fd_isdir, STDERR);
-      struct file *file_to_isdir = t_isdir->set_of_files[fd_isdir];
-      // Additional check done in case a file with valid fd
-      // was closed earlier, so exit with -1 error status
-      // when such a thing happens.
-      file_exist_check(file_to_isdir);
-      // Simply call our inodeisdir method here.
-      f->eax = inode_is_dir(file_get_inode(file_to_isdir));
-    
-    // Brock done driving,
-    // Viren driving now.
-    /* This system call returns the inode number of the inode
-    corresponding with the given file descriptor. */
-    case SYS_INUMBER:
-      temp_esp += sizeof(int);
-      valid_pointer_check(temp_esp);
-      int fd_inumber = *(int *) temp_esp;
-      struct thread *t_inumber = thread_current();
-      fd_exist_check(t_inumber, fd_inumber, STDERR);
-      struct file *file_to_inumber = t_inumber->set_of_files[fd_inumber];
-      // Additional check done in case a file with valid fd
-      // was closed earlier, so exit with -1 error status
-      // when such a thing happens.
-      file_exist_check(file_to_inumber);
-      // Simply call the inumber method here.
-      f->eax = inode_get_inumber(file_get_inode(file_to_inumber));
+/* Carries out all the calls queued in the process's batch ring, in
+order, for as long as there is room for their results, in a single
+kernel entry. Each call's arguments are checked just as for a
+direct call. Returns the number of calls carried out, or -1 if no
+ring is registered. */
+static uint32_t
+sys_batch_enter (struct intr_frame *f, const uint32_t *args UNUSED)
+{
+  struct batch_ring *ring = thread_current()->batch_ring;
+  unsigned idx[4];              // sq_head, sq_tail, cq_head, cq_tail.
+  unsigned sq_head, cq_tail;
+  enum intr_level old_level;
+  uint64_t inner_cycles = 0;
+  int done = 0;
+
+  if(ring == NULL)
+    return ERROR;
+
+  // Only the process's indexes can have changed since last time,
+  // but read all four in one go.
+  if(!copy_in(idx, &ring->sq_head, sizeof idx))
+    exit(ERROR);
+  sq_head = idx[0];
+  cq_tail = idx[3];
+  if(idx[1] - sq_head > BATCH_RING_SIZE || cq_tail - idx[2] > BATCH_RING_SIZE)
+    exit(ERROR);
+
+  while(sq_head != idx[1] && cq_tail - idx[2] < BATCH_RING_SIZE)
+  {
+    struct batch_sqe sqe;
+    struct batch_cqe cqe;
+
+    if(!copy_in(&sqe, &ring->sq[sq_head % BATCH_RING_SIZE], sizeof sqe))
+      exit(ERROR);
+    cqe.tag = sqe.tag;
+    if(batchable(&sqe))
+    {
+      uint64_t start = read_tsc();
+      cqe.result = run_syscall(f, &syscalls[sqe.nr], sqe.args);
+      inner_cycles += read_tsc() - start;
+    }
+    else
+      cqe.result = ERROR;
+    if(!copy_out(&ring->cq[cq_tail % BATCH_RING_SIZE], &cqe, sizeof cqe))
+      exit(ERROR);
+    sq_head++;
+    cq_tail++;
+    done++;
   }
-  // End of Viren driving
+
+  // Publish the new indexes once all the results are in place.
+  if(!copy_out(&ring->sq_head, &sq_head, sizeof sq_head)
+     || !copy_out(&ring->cq_tail, &cq_tail, sizeof cq_tail))
+    exit(ERROR);
+
+  // The calls we ran have had their cycles counted already, so
+  // leave them out of ours, which run_syscall() adds on return.
+  old_level = intr_disable();
+  syscalls[SYS_BATCH_ENTER].cycles -= inner_cycles;
+  intr_set_level(old_level);
+  return done;
 }
+
+// End of Viren driving
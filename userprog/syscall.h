@@ -2,6 +2,7 @@
 #define USERPROG_SYSCALL_H
 
 void syscall_init (void);
+void syscall_print_stats (void);
 void valid_pointer_check(void * ptr); /*checks if pointer is valid. */
 struct lock write_lock; /* Used for critical section invovling write calls. */
 
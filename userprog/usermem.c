@@ -0,0 +1,137 @@
+#include "userprog/usermem.h"
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+
+/* Labels on the instructions in get_user() and put_user() that
+   access user memory, and where each continues after a fault.
+   Defined in the inline assembly below. */
+extern const char get_user_access[], get_user_fixup[];
+extern const char put_user_access[], put_user_fixup[];
+
+/* Reads a byte at user virtual address UADDR, which must be
+   below PHYS_BASE.  Returns the byte value if successful, -1 if
+   a segfault occurred.
+
+   Must not be inlined, since its labels may appear only
+   once. */
+int __attribute__ ((noinline))
+get_user (const uint8_t *uaddr)
+{
+  int result;
+  asm volatile ("movl $get_user_fixup, %0\n"
+                "get_user_access:\n\t"
+                "movzbl %1, %0\n"
+                "get_user_fixup:"
+                : "=&a" (result) : "m" (*uaddr));
+  return result;
+}
+
+/* Writes BYTE to user address UDST, which must be below
+   PHYS_BASE.  Returns true if successful, false if a segfault
+   occurred.
+
+   Must not be inlined, since its labels may appear only
+   once. */
+bool __attribute__ ((noinline))
+put_user (uint8_t *udst, uint8_t byte)
+{
+  int error_code;
+  asm volatile ("movl $put_user_fixup, %0\n"
+                "put_user_access:\n\t"
+                "movb %b2, %1\n"
+                "put_user_fixup:"
+                : "=&a" (error_code), "=m" (*udst) : "q" (byte));
+  return error_code != -1;
+}
+
+/* Called by page_fault() for a fault in kernel context that it
+   could not resolve.  If F is at one of the user memory accesses
+   above, makes the access fail and returns true.  Otherwise,
+   returns false, and the fault is a kernel bug. */
+bool
+usermem_fixup (struct intr_frame *f)
+{
+  const char *eip = (const char *) f->eip;
+
+  if (eip == get_user_access || eip == put_user_access)
+    {
+      f->eip = (void (*) (void)) f->eax;
+      f->eax = 0xffffffff;
+      return true;
+    }
+  return false;
+}
+
+/* Returns true if the SIZE bytes starting at UADDR lie entirely
+   in user address space, without checking whether they are
+   mapped. */
+bool
+is_user_range (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Returns true if the SIZE bytes starting at UADDR are all
+   readable user memory and, if WRITABLE, writable as well.
+   Touches one byte per page, bringing in any page that is
+   swapped out and unsharing any copy-on-write page that is to be
+   written, so the range can then be accessed directly. */
+bool
+check_user_range (const void *uaddr, size_t size, bool writable)
+{
+  uint8_t *p = (uint8_t *) uaddr;
+  uint8_t *end = p + size;
+
+  if (!is_user_range (uaddr, size))
+    return false;
+  while (p < end)
+    {
+      int byte = get_user (p);
+      if (byte < 0 || (writable && !put_user (p, byte)))
+        return false;
+      p = (uint8_t *) pg_round_down (p) + PGSIZE;
+    }
+  return true;
+}
+
+/* Returns true if USTR is a null-terminated string entirely in
+   readable user memory. */
+bool
+check_user_string (const char *ustr)
+{
+  const uint8_t *p = (const uint8_t *) ustr;
+
+  for (; is_user_vaddr (p); p++)
+    {
+      int byte = get_user (p);
+      if (byte <= 0)
+        return byte == 0;
+    }
+  return false;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns false if any part of the source is not readable
+   user memory. */
+bool
+copy_in (void *dst, const void *usrc, size_t size)
+{
+  if (!check_user_range (usrc, size, false))
+    return false;
+  memcpy (dst, usrc, size);
+  return true;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns false if any part of the destination is not
+   writable user memory. */
+bool
+copy_out (void *udst, const void *src, size_t size)
+{
+  if (!check_user_range (udst, size, true))
+    return false;
+  memcpy (udst, src, size);
+  return true;
+}
@@ -0,0 +1,29 @@
+#ifndef USERPROG_USERMEM_H
+#define USERPROG_USERMEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct intr_frame;
+
+/* Access to user memory from the kernel.
+
+   Instead of walking the page table to check each user address
+   before using it, these functions just access the memory and
+   let the MMU check it.  If the access faults and the page
+   cannot be brought in, page_fault() calls usermem_fixup(),
+   which makes the access return failure instead of killing the
+   kernel. */
+
+int get_user (const uint8_t *uaddr);
+bool put_user (uint8_t *udst, uint8_t byte);
+bool usermem_fixup (struct intr_frame *);
+
+bool is_user_range (const void *uaddr, size_t size);
+bool check_user_range (const void *uaddr, size_t size, bool writable);
+bool check_user_string (const char *ustr);
+bool copy_in (void *dst, const void *usrc, size_t size);
+bool copy_out (void *udst, const void *src, size_t size);
+
+#endif /* userprog/usermem.h */
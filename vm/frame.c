@@ -0,0 +1,775 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/swap.h"
+
+/* Frame table.
+
+   Every user page that is mapped into a process's page directory
+   is tracked here by its kernel virtual address, together with
+   the number of mappings that refer to it.  A frame is given back
+   to the page allocator only when its last mapping goes away.
+
+   Read-only pages loaded from an executable are also entered
+   into the share table, keyed by the executable's inode and the
+   page's position within it.  A process that loads a page that
+   is already resident simply maps the existing frame instead of
+   allocating and reading a new one, so starting another instance
+   of a program that is already running costs almost no memory or
+   disk I/O for its code.  A shared frame holds its own reference
+   to the inode, so the key stays unique for as long as the frame
+   exists.
+
+   There is also a single all-zero frame that is mapped
+   copy-on-write in place of every page that starts out zeroed
+   and has not been written yet, such as most of a program's
+   BSS.  It is never freed.
+
+   Finally, when the user pool runs dry, a private frame that is
+   mapped by exactly one process (its "owner") is evicted to
+   swap, chosen by the clock algorithm.  Frames whose contents
+   are already in swap, and unchanged since, are preferred, since
+   evicting them costs no I/O.  To keep such frames available, a
+   low-priority cleaner thread wakes up whenever free frames drop
+   below a watermark and writes dirty frames ahead of the clock
+   hand to swap while they stay mapped.  A frame is "pinned"
+   while the cleaner writes it out; it is neither evicted nor
+   freed until the write completes.
+
+   Swap I/O for eviction and page-in is done with the frame lock
+   held, which keeps eviction simple at the cost of serializing
+   page faults behind it.  The cleaner drops the lock for its
+   writes, so the foreground path rarely has to write at all. */
+
+/* A physical frame holding a user page. */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address. */
+    unsigned ref_cnt;           /* Number of mappings of this frame. */
+    struct hash_elem elem;      /* Element in frame_table. */
+    struct list_elem list_elem; /* Element in frame_list. */
+
+    /* Evictable frames only. */
+    uint32_t *pd;               /* Owner's page directory, or null. */
+    void *upage;                /* Owner's virtual address for page. */
+    struct thread *thread;      /* Owner, for its statistics. */
+    size_t slot;                /* Swap slot with a copy, or SWAP_ERROR. */
+    bool pinned;                /* Being written out by the cleaner? */
+
+    /* Shared read-only executable pages only. */
+    struct inode *inode;        /* Backing executable, or null. */
+    off_t ofs;                  /* Offset of the page in INODE. */
+    size_t read_bytes;          /* Bytes read from INODE, rest zero. */
+    struct hash_elem share_elem; /* Element in share_table. */
+  };
+
+/* Maximum number of frames the cleaner writes per wakeup. */
+#define CLEAN_BATCH 16
+
+static struct hash frame_table;         /* All frames, by kpage. */
+static struct hash share_table;         /* Shared frames, by inode. */
+static struct list frame_list;          /* All frames, in clock order. */
+static struct list_elem *clock_hand;    /* Next frame for the clock. */
+static struct lock frame_lock;          /* Protects all of the above. */
+static struct condition frame_unpinned; /* Signaled when unpinning. */
+static void *zero_page;                 /* The shared zero frame. */
+
+static size_t clean_watermark;          /* Wake the cleaner below this. */
+static bool cleaner_wanted;             /* Cleaner woken, not done yet? */
+static struct semaphore cleaner_sema;   /* Wakes the cleaner. */
+
+static hash_hash_func frame_hash, share_hash;
+static hash_less_func frame_less, share_less;
+static struct frame *frame_lookup (void *kpage);
+static struct frame *share_lookup (struct inode *, off_t, size_t);
+static void *alloc_locked (enum palloc_flags);
+static bool unref_locked (struct frame *);
+static void destroy (struct frame *);
+static void map_locked (struct frame *, uint32_t *pd, void *upage);
+static bool page_in_locked (uint32_t *pd, void *upage);
+static struct frame *evict (void);
+static struct frame *pick_victim (void);
+static struct frame *clock_next (void);
+static thread_func cleaner NO_RETURN;
+static void clean_frames (void);
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  hash_init (&frame_table, frame_hash, frame_less, NULL);
+  hash_init (&share_table, share_hash, share_less, NULL);
+  list_init (&frame_list);
+  lock_init (&frame_lock);
+  cond_init (&frame_unpinned);
+  sema_init (&cleaner_sema, 0);
+  clean_watermark = palloc_user_page_cnt () / 16;
+
+  /* The zero frame's initial reference is never dropped. */
+  zero_page = frame_alloc (PAL_ZERO | PAL_ASSERT);
+}
+
+/* Starts the page cleaner thread.  Should be called once swap
+   space has been initialized. */
+void
+frame_start_cleaner (void)
+{
+  thread_create ("pgcleaner", PRI_MIN, cleaner, NULL);
+}
+
+/* Obtains a page from the user pool, passing FLAGS on to
+   palloc_get_page(), and enters it into the frame table with a
+   single reference.  If the pool is exhausted, a frame is
+   evicted to make room.  Returns its kernel virtual address, or
+   a null pointer if no memory is available. */
+void *
+frame_alloc (enum palloc_flags flags)
+{
+  void *kpage;
+
+  lock_acquire (&frame_lock);
+  kpage = alloc_locked (flags);
+  lock_release (&frame_lock);
+  return kpage;
+}
+
+/* Drops one reference to the frame at KPAGE, which must have
+   been obtained from frame_alloc(), frame_get_zero(), or
+   frame_get_shared().  When the last reference goes away, the
+   frame is returned to the page allocator. */
+void
+frame_free (void *kpage)
+{
+  struct frame *f;
+  bool dead;
+
+  lock_acquire (&frame_lock);
+  f = frame_lookup (kpage);
+  ASSERT (f != NULL);
+  dead = unref_locked (f);
+  lock_release (&frame_lock);
+
+  if (dead)
+    destroy (f);
+}
+
+/* Adds a reference to the frame at KPAGE, for a new mapping of
+   it in another page directory. */
+void
+frame_ref (void *kpage)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  f = frame_lookup (kpage);
+  ASSERT (f != NULL);
+  f->ref_cnt++;
+  f->pd = NULL;
+  lock_release (&frame_lock);
+}
+
+/* Records that the frame at KPAGE has just been mapped at UPAGE
+   in PD.  If that is the frame's only mapping and the frame is
+   private, PD becomes its owner and the frame may be evicted. */
+void
+frame_map (void *kpage, uint32_t *pd, void *upage)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  f = frame_lookup (kpage);
+  ASSERT (f != NULL);
+  map_locked (f, pd, upage);
+  lock_release (&frame_lock);
+}
+
+/* Releases whatever user virtual page UPAGE in PD refers to:
+   its frame if it is resident or its swap slot if it is not.
+   Used when destroying PD. */
+void
+frame_unmap (uint32_t *pd, void *upage)
+{
+  struct frame *f = NULL;
+  bool dead = false;
+
+  lock_acquire (&frame_lock);
+  for (;;)
+    {
+      void *kpage = pagedir_get_page (pd, upage);
+      bool writable;
+      size_t slot;
+
+      if (kpage != NULL)
+        {
+          f = frame_lookup (kpage);
+          ASSERT (f != NULL);
+          if (f->pinned)
+            {
+              /* The page may be evicted while we wait. */
+              cond_wait (&frame_unpinned, &frame_lock);
+              continue;
+            }
+          dead = unref_locked (f);
+        }
+      else if ((slot = pagedir_get_swap (pd, upage, &writable))
+               != SWAP_ERROR)
+        swap_free (slot);
+      break;
+    }
+  lock_release (&frame_lock);
+
+  if (dead)
+    destroy (f);
+}
+
+/* Brings the page containing user virtual address UADDR in PD
+   back in from swap.  Returns true if successful or if the page
+   is already resident, false if the page is neither resident nor
+   swapped out or no frame can be found for it. */
+bool
+frame_page_in (uint32_t *pd, const void *uaddr)
+{
+  bool success;
+
+  lock_acquire (&frame_lock);
+  success = page_in_locked (pd, pg_round_down (uaddr));
+  lock_release (&frame_lock);
+  return success;
+}
+
+/* Adds a reference to the frame mapped at user virtual page
+   UPAGE in PD, for a copy of that mapping in a forked process,
+   first bringing the page in from swap if necessary.  The frame
+   can no longer be evicted.  Returns false if the page could not
+   be brought in. */
+bool
+frame_share (uint32_t *pd, void *upage)
+{
+  struct frame *f = NULL;
+
+  lock_acquire (&frame_lock);
+  while (page_in_locked (pd, upage))
+    {
+      f = frame_lookup (pagedir_get_page (pd, upage));
+      if (f->pinned)
+        {
+          /* The cleaner is writing F to its swap slot, which we
+             must not free under it.  The page may be evicted
+             while we wait. */
+          f = NULL;
+          cond_wait (&frame_unpinned, &frame_lock);
+          continue;
+        }
+      f->ref_cnt++;
+      f->pd = NULL;
+
+      /* The page may be modified before it is owned again. */
+      if (f->slot != SWAP_ERROR)
+        {
+          swap_free (f->slot);
+          f->slot = SWAP_ERROR;
+        }
+      break;
+    }
+  lock_release (&frame_lock);
+  return f != NULL;
+}
+
+/* Returns a frame that the caller, which holds a reference to
+   the frame at KPAGE, may write to in its place.  If the caller
+   holds the only reference, that is KPAGE itself.  Otherwise the
+   contents are copied into a newly allocated frame and the
+   caller's reference to KPAGE is dropped.  Returns a null
+   pointer, leaving the reference to KPAGE intact, if no memory
+   is available. */
+void *
+frame_unshare (void *kpage)
+{
+  struct frame *f;
+  void *copy;
+
+  lock_acquire (&frame_lock);
+  f = frame_lookup (kpage);
+  ASSERT (f != NULL);
+  if (f->ref_cnt == 1 && f->inode == NULL)
+    {
+      lock_release (&frame_lock);
+      return kpage;
+    }
+  lock_release (&frame_lock);
+
+  /* Our reference keeps KPAGE alive while we copy it. */
+  if (kpage == zero_page)
+    copy = frame_alloc (PAL_ZERO);
+  else
+    {
+      copy = frame_alloc (0);
+      if (copy != NULL)
+        memcpy (copy, kpage, PGSIZE);
+    }
+  if (copy == NULL)
+    return NULL;
+  frame_free (kpage);
+  return copy;
+}
+
+/* Returns the shared all-zero frame, with a new reference that
+   the caller must release with frame_free().  The caller must
+   map it read-only, or copy-on-write if the page is to become
+   writable. */
+void *
+frame_get_zero (void)
+{
+  frame_ref (zero_page);
+  return zero_page;
+}
+
+/* Returns a read-only frame holding the page of FILE that starts
+   at offset OFS, with its first READ_BYTES bytes read from FILE
+   and the rest zeroed.  If another process already has that page
+   resident, its frame is shared and only its reference count
+   goes up; otherwise a new frame is loaded and published for
+   later loads to find.  Returns a null pointer if memory cannot
+   be allocated or FILE cannot be read.
+
+   The caller must map the frame read-only and release it with
+   frame_free(). */
+void *
+frame_get_shared (struct file *file, off_t ofs, size_t read_bytes)
+{
+  struct inode *inode = file_get_inode (file);
+  struct frame *f;
+  uint8_t *kpage;
+
+  ASSERT (read_bytes <= PGSIZE);
+
+  lock_acquire (&frame_lock);
+  f = share_lookup (inode, ofs, read_bytes);
+  if (f != NULL)
+    {
+      f->ref_cnt++;
+      lock_release (&frame_lock);
+      return f->kpage;
+    }
+  lock_release (&frame_lock);
+
+  /* Not resident.  Load a copy without holding the lock, so
+     that other processes' page faults and exits aren't held up
+     behind our disk I/O. */
+  kpage = frame_alloc (0);
+  if (kpage == NULL)
+    return NULL;
+  if (file_read_at (file, kpage, read_bytes, ofs) != (off_t) read_bytes)
+    {
+      frame_free (kpage);
+      return NULL;
+    }
+  memset (kpage + read_bytes, 0, PGSIZE - read_bytes);
+
+  /* Publish it, unless another process loaded the same page in
+     the meantime, in which case we use theirs. */
+  lock_acquire (&frame_lock);
+  f = share_lookup (inode, ofs, read_bytes);
+  if (f != NULL)
+    {
+      void *shared = f->kpage;
+      f->ref_cnt++;
+      lock_release (&frame_lock);
+      frame_free (kpage);
+      return shared;
+    }
+  f = frame_lookup (kpage);
+  f->inode = inode_reopen (inode);
+  f->ofs = ofs;
+  f->read_bytes = read_bytes;
+  hash_insert (&share_table, &f->share_elem);
+  lock_release (&frame_lock);
+  return kpage;
+}
+
+/* Allocates a frame as for frame_alloc().  The frame lock must
+   be held. */
+static void *
+alloc_locked (enum palloc_flags flags)
+{
+  struct frame *f;
+  void *kpage;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  kpage = palloc_get_page (PAL_USER | flags);
+  if (kpage != NULL)
+    {
+      f = malloc (sizeof *f);
+      if (f == NULL)
+        {
+          palloc_free_page (kpage);
+          return NULL;
+        }
+      f->kpage = kpage;
+      hash_insert (&frame_table, &f->elem);
+      list_push_back (&frame_list, &f->list_elem);
+    }
+  else
+    {
+      f = evict ();
+      if (f == NULL)
+        return NULL;
+      if (flags & PAL_ZERO)
+        memset (f->kpage, 0, PGSIZE);
+    }
+  f->ref_cnt = 1;
+  f->pd = NULL;
+  f->thread = NULL;
+  f->slot = SWAP_ERROR;
+  f->pinned = false;
+  f->inode = NULL;
+
+  /* Running low: have dirty frames written out in the
+     background, so that later evictions find clean ones. */
+  if (!cleaner_wanted
+      && palloc_user_page_cnt () - hash_size (&frame_table)
+         < clean_watermark)
+    {
+      cleaner_wanted = true;
+      sema_up (&cleaner_sema);
+    }
+  return f->kpage;
+}
+
+/* Drops one reference to F.  If that was the last, removes F
+   from the tables and returns true; the caller must then pass F
+   to destroy() after releasing the frame lock. */
+static bool
+unref_locked (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (f->ref_cnt > 0);
+  ASSERT (!f->pinned);
+
+  if (--f->ref_cnt > 0)
+    return false;
+
+  hash_delete (&frame_table, &f->elem);
+  if (clock_hand == &f->list_elem)
+    clock_hand = list_next (clock_hand);
+  list_remove (&f->list_elem);
+  if (f->inode != NULL)
+    hash_delete (&share_table, &f->share_elem);
+  if (f->slot != SWAP_ERROR)
+    swap_free (f->slot);
+  return true;
+}
+
+/* Returns unreferenced frame F to the page allocator.  Must not
+   be called with the frame lock held, since closing F's inode
+   may require file system locks that are held while faulting on
+   user memory. */
+static void
+destroy (struct frame *f)
+{
+  inode_close (f->inode);
+  palloc_free_page (f->kpage);
+  free (f);
+}
+
+/* Makes PD the owner of F, which has just been mapped at UPAGE
+   in PD, if that mapping is F's only one and F is private. */
+static void
+map_locked (struct frame *f, uint32_t *pd, void *upage)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (f->ref_cnt == 1 && f->inode == NULL && f->kpage != zero_page)
+    {
+      f->pd = pd;
+      f->upage = upage;
+      f->thread = thread_current ();
+    }
+}
+
+/* Reads user virtual page UPAGE of PD back in from swap, if it
+   is swapped out.  Returns true if UPAGE ends up resident.  The
+   frame lock must be held. */
+static bool
+page_in_locked (uint32_t *pd, void *upage)
+{
+  struct vmstat *vs = &thread_current ()->vmstat;
+  struct frame *f;
+  bool writable;
+  size_t slot;
+  void *kpage;
+
+  slot = pagedir_get_swap (pd, upage, &writable);
+  if (slot == SWAP_ERROR)
+    return pagedir_get_page (pd, upage) != NULL;
+
+  kpage = alloc_locked (0);
+  if (kpage == NULL)
+    return false;
+  swap_read (slot, kpage);
+  f = frame_lookup (kpage);
+  if (!pagedir_set_page (pd, upage, kpage, writable))
+    {
+      /* F is private, so there is no inode to close. */
+      unref_locked (f);
+      palloc_free_page (kpage);
+      free (f);
+      return false;
+    }
+
+  /* The swap slot keeps a clean copy until the page is dirtied,
+     so that evicting it again costs no I/O. */
+  f->slot = slot;
+  map_locked (f, pd, upage);
+  vs->major_faults++;
+  vs->swap_ins++;
+  return true;
+}
+
+/* Takes a frame away from its owner, writing its contents to
+   swap first unless an up-to-date copy is already there, and
+   returns it, still in the frame table, for reuse.  Returns a
+   null pointer if no frame can be evicted. */
+static struct frame *
+evict (void)
+{
+  enum intr_level old_level;
+  struct frame *f;
+  bool dirty;
+
+  f = pick_victim ();
+  if (f == NULL)
+    return NULL;
+  if (f->slot == SWAP_ERROR)
+    {
+      f->slot = swap_alloc ();
+      if (f->slot == SWAP_ERROR)
+        return NULL;
+      dirty = true;
+    }
+  else
+    dirty = false;
+
+  /* Unmap the page before writing it, so that the owner can't
+     change it underneath us.  Interrupts are off so that the
+     owner can't dirty it between the check and the unmap. */
+  old_level = intr_disable ();
+  dirty = dirty || pagedir_is_dirty (f->pd, f->upage);
+  pagedir_set_swap (f->pd, f->upage, f->slot);
+  intr_set_level (old_level);
+
+  if (dirty)
+    {
+      swap_write (f->slot, f->kpage);
+      f->thread->vmstat.swap_outs++;
+    }
+  thread_current ()->vmstat.evictions++;
+
+  /* The slot now belongs to the owner's page table entry. */
+  f->slot = SWAP_ERROR;
+  f->pd = NULL;
+  return f;
+}
+
+/* Chooses a frame to evict using the clock algorithm, giving
+   recently accessed frames a second chance.  A frame whose swap
+   copy is current is taken as soon as it is found; otherwise the
+   first dirty candidate seen is used.  Returns a null pointer if
+   no frame is evictable. */
+static struct frame *
+pick_victim (void)
+{
+  struct frame *dirty_victim = NULL;
+  size_t i;
+
+  for (i = 0; i < 2 * hash_size (&frame_table); i++)
+    {
+      struct frame *f = clock_next ();
+
+      if (f->pd == NULL || f->pinned)
+        continue;
+      if (pagedir_is_accessed (f->pd, f->upage))
+        {
+          pagedir_set_accessed (f->pd, f->upage, false);
+          continue;
+        }
+      if (f->slot != SWAP_ERROR && !pagedir_is_dirty (f->pd, f->upage))
+        return f;
+      if (dirty_victim == NULL)
+        dirty_victim = f;
+    }
+  return dirty_victim;
+}
+
+/* Returns the frame under the clock hand and advances the hand.
+   There must be at least one frame. */
+static struct frame *
+clock_next (void)
+{
+  struct frame *f;
+
+  ASSERT (!list_empty (&frame_list));
+  if (clock_hand == NULL || clock_hand == list_end (&frame_list))
+    clock_hand = list_begin (&frame_list);
+  f = list_entry (clock_hand, struct frame, list_elem);
+  clock_hand = list_next (clock_hand);
+  return f;
+}
+
+/* Page cleaner thread.  Each time free frames run low, writes a
+   batch of dirty frames to swap. */
+static void
+cleaner (void *aux UNUSED)
+{
+  for (;;)
+    {
+      sema_down (&cleaner_sema);
+      lock_acquire (&frame_lock);
+      clean_frames ();
+      cleaner_wanted = false;
+      lock_release (&frame_lock);
+    }
+}
+
+/* Writes up to CLEAN_BATCH dirty, evictable frames that the
+   clock hand will reach soon to swap, leaving them mapped.
+   Recently accessed frames are skipped, since they are likely to
+   be dirtied again.  The frame lock must be held; it is released
+   during each write. */
+static void
+clean_frames (void)
+{
+  struct list_elem *e = clock_hand;
+  size_t cleaned = 0;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  for (i = 0; i < hash_size (&frame_table) && cleaned < CLEAN_BATCH; i++)
+    {
+      enum intr_level old_level;
+      struct frame *f;
+
+      if (e == NULL || e == list_end (&frame_list))
+        e = list_begin (&frame_list);
+      f = list_entry (e, struct frame, list_elem);
+      e = list_next (e);
+
+      if (f->pd == NULL || f->pinned
+          || pagedir_is_accessed (f->pd, f->upage))
+        continue;
+      if (f->slot == SWAP_ERROR)
+        {
+          f->slot = swap_alloc ();
+          if (f->slot == SWAP_ERROR)
+            break;
+        }
+      else if (!pagedir_is_dirty (f->pd, f->upage))
+        continue;
+
+      /* Clear the dirty bit before writing: if the owner writes
+         to the page while we are at it, the page just becomes
+         dirty again. */
+      old_level = intr_disable ();
+      pagedir_set_dirty (f->pd, f->upage, false);
+      intr_set_level (old_level);
+
+      f->pinned = true;
+      lock_release (&frame_lock);
+      swap_write (f->slot, f->kpage);
+      lock_acquire (&frame_lock);
+      f->pinned = false;
+      f->thread->vmstat.swap_outs++;
+      cond_broadcast (&frame_unpinned, &frame_lock);
+
+      /* Pinning kept F in the list, but its old neighbor may be
+         gone. */
+      e = list_next (&f->list_elem);
+      cleaned++;
+    }
+}
+
+/* Returns the frame for KPAGE, or a null pointer if there is
+   none.  The frame lock must be held. */
+static struct frame *
+frame_lookup (void *kpage)
+{
+  struct frame f;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  f.kpage = kpage;
+  e = hash_find (&frame_table, &f.elem);
+  return e != NULL ? hash_entry (e, struct frame, elem) : NULL;
+}
+
+/* Returns the shared frame for the page of INODE at OFS with
+   READ_BYTES bytes of file data, or a null pointer if there is
+   none.  The frame lock must be held. */
+static struct frame *
+share_lookup (struct inode *inode, off_t ofs, size_t read_bytes)
+{
+  struct frame f;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  f.inode = inode;
+  f.ofs = ofs;
+  f.read_bytes = read_bytes;
+  e = hash_find (&share_table, &f.share_elem);
+  return e != NULL ? hash_entry (e, struct frame, share_elem) : NULL;
+}
+
+/* Returns a hash value for frame_table element E. */
+static unsigned
+frame_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, elem);
+  return hash_bytes (&f->kpage, sizeof f->kpage);
+}
+
+/* Returns true if frame_table element A precedes B. */
+static bool
+frame_less (const struct hash_elem *a, const struct hash_elem *b,
+            void *aux UNUSED)
+{
+  const struct frame *fa = hash_entry (a, struct frame, elem);
+  const struct frame *fb = hash_entry (b, struct frame, elem);
+  return fa->kpage < fb->kpage;
+}
+
+/* Returns a hash value for share_table element E. */
+static unsigned
+share_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, share_elem);
+  return (hash_bytes (&f->inode, sizeof f->inode)
+          ^ hash_int (f->ofs) ^ hash_int (f->read_bytes));
+}
+
+/* Returns true if share_table element A precedes B. */
+static bool
+share_less (const struct hash_elem *a, const struct hash_elem *b,
+            void *aux UNUSED)
+{
+  const struct frame *fa = hash_entry (a, struct frame, share_elem);
+  const struct frame *fb = hash_entry (b, struct frame, share_elem);
+
+  if (fa->inode != fb->inode)
+    return fa->inode < fb->inode;
+  else if (fa->ofs != fb->ofs)
+    return fa->ofs < fb->ofs;
+  else
+    return fa->read_bytes < fb->read_bytes;
+}
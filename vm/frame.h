@@ -0,0 +1,25 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "threads/palloc.h"
+
+struct file;
+
+void frame_init (void);
+void frame_start_cleaner (void);
+void *frame_alloc (enum palloc_flags);
+void frame_free (void *kpage);
+void frame_ref (void *kpage);
+void frame_map (void *kpage, uint32_t *pd, void *upage);
+void frame_unmap (uint32_t *pd, void *upage);
+bool frame_page_in (uint32_t *pd, const void *uaddr);
+bool frame_share (uint32_t *pd, void *upage);
+void *frame_unshare (void *kpage);
+void *frame_get_zero (void);
+void *frame_get_shared (struct file *, off_t ofs, size_t read_bytes);
+
+#endif /* vm/frame.h */
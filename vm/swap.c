@@ -0,0 +1,84 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include "devices/block.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Swap space.
+
+   The swap block device is divided into page-sized slots, each
+   of which holds the contents of one evicted user page.  Slots
+   are handed out and reclaimed through a bitmap.  If there is no
+   swap device, every swap_alloc() fails and user pages simply
+   cannot be evicted. */
+
+/* Number of sectors in a swap slot. */
+#define SLOT_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+static struct block *swap_device;       /* Swap device, or null. */
+static struct bitmap *used_slots;       /* Allocated slots. */
+static struct lock swap_lock;           /* Protects used_slots. */
+
+/* Initializes swap space on the block device with the swap
+   role, if there is one. */
+void
+swap_init (void)
+{
+  lock_init (&swap_lock);
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device == NULL)
+    return;
+
+  used_slots = bitmap_create (block_size (swap_device) / SLOT_SECTORS);
+  if (used_slots == NULL)
+    PANIC ("bitmap creation failed--swap device is too large");
+}
+
+/* Allocates a swap slot and returns its number, or SWAP_ERROR
+   if swap space is exhausted or there is no swap device. */
+size_t
+swap_alloc (void)
+{
+  size_t slot;
+
+  if (used_slots == NULL)
+    return SWAP_ERROR;
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip_next (used_slots, 1, false);
+  lock_release (&swap_lock);
+  return slot != BITMAP_ERROR ? slot : SWAP_ERROR;
+}
+
+/* Makes SLOT available for reuse. */
+void
+swap_free (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  bitmap_reset (used_slots, slot);
+  lock_release (&swap_lock);
+}
+
+/* Reads the page stored in SLOT into KPAGE. */
+void
+swap_read (size_t slot, void *kpage)
+{
+  size_t i;
+
+  for (i = 0; i < SLOT_SECTORS; i++)
+    block_read (swap_device, slot * SLOT_SECTORS + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+}
+
+/* Writes the page at KPAGE into SLOT. */
+void
+swap_write (size_t slot, const void *kpage)
+{
+  size_t i;
+
+  for (i = 0; i < SLOT_SECTORS; i++)
+    block_write (swap_device, slot * SLOT_SECTORS + i,
+                 (const uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+}